@@ -1,8 +1,20 @@
 %%writefile jancok2.c
 
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 typedef struct Node {
     int data;
@@ -43,6 +55,15 @@ void deleteNoCacheList(NoCacheList* list, int data) {
     }
 }
 
+int containsNoCacheList(NoCacheList* list, int data) {
+    for (Node* current = list->head; current != NULL; current = current->next) {
+        if (current->data == data) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 void clearNoCacheList(NoCacheList* list) {
     Node* current = list->head;
     while (current != NULL) {
@@ -54,12 +75,107 @@ void clearNoCacheList(NoCacheList* list) {
 }
 
 
+// Relinearization. After heavy churn the nodes of a list are scattered across
+// the heap and every hop is a random access. compactNodes copies the live
+// nodes into one contiguous slab in list order and frees the old ones. Slab
+// nodes are never freed one by one: the whole slab is released by the next
+// compaction or by clear. Delete walks sample every COMPACT_SAMPLE_STRIDE-th
+// hop, count how many of the sampled hops jump more than a cache line in
+// either direction, and compact automatically once that share crosses the
+// threshold. A list built by pushing at the head runs through adjacent nodes
+// at descending addresses, which counts as near.
+
+#define COMPACT_SAMPLE_STRIDE 16
+#define COMPACT_MIN_HOPS 4096
+#define COMPACT_SCATTER_PERCENT 50
+
+typedef struct NodeSlab {
+    Node* nodes;
+    int count;
+    long hops;
+    long farHops;
+} NodeSlab;
+
+void initNodeSlab(NodeSlab* slab) {
+    slab->nodes = NULL;
+    slab->count = 0;
+    slab->hops = 0;
+    slab->farHops = 0;
+}
+
+int inNodeSlab(NodeSlab* slab, Node* node) {
+    return slab->nodes != NULL && node >= slab->nodes && node < slab->nodes + slab->count;
+}
+
+void releaseNode(NodeSlab* slab, Node* node) {
+    if (!inNodeSlab(slab, node)) {
+        free(node);
+    }
+}
+
+void noteNodeHop(NodeSlab* slab, Node* from, Node* to) {
+    long distance = (char*)to - (char*)from;
+    slab->hops++;
+    if (distance < -64 || distance > 64) {
+        slab->farHops++;
+    }
+}
+
+int shouldCompactNodes(NodeSlab* slab) {
+    return slab->hops >= COMPACT_MIN_HOPS && slab->farHops * 100 >= slab->hops * COMPACT_SCATTER_PERCENT;
+}
+
+Node* compactNodes(NodeSlab* slab, Node* head) {
+    int count = 0;
+    for (Node* current = head; current != NULL; current = current->next) {
+        count++;
+    }
+
+    Node* nodes = NULL;
+    if (count > 0) {
+        nodes = (Node*)malloc(count * sizeof(Node));
+        if (nodes == NULL) {
+            return head;
+        }
+    }
+
+    Node* current = head;
+    for (int i = 0; i < count; i++) {
+        Node* next = current->next;
+        nodes[i].data = current->data;
+        nodes[i].next = i + 1 < count ? &nodes[i + 1] : NULL;
+        releaseNode(slab, current);
+        current = next;
+    }
+
+    free(slab->nodes);
+    slab->nodes = nodes;
+    slab->count = count;
+    slab->hops = 0;
+    slab->farHops = 0;
+    return nodes;
+}
+
+void clearNodes(NodeSlab* slab, Node* head) {
+    Node* current = head;
+    while (current != NULL) {
+        Node* next = current->next;
+        releaseNode(slab, current);
+        current = next;
+    }
+    free(slab->nodes);
+    initNodeSlab(slab);
+}
+
+
 typedef struct LinkedList {
     Node* head;
+    NodeSlab slab;
 } LinkedList;
 
 void initLinkedList(LinkedList* list) {
     list->head = NULL;
+    initNodeSlab(&list->slab);
 }
 
 void insertLinkedList(LinkedList* list, int data) {
@@ -69,9 +185,14 @@ void insertLinkedList(LinkedList* list, int data) {
     list->head = newNode;
 }
 
+void compactLinkedList(LinkedList* list) {
+    list->head = compactNodes(&list->slab, list->head);
+}
+
 void deleteLinkedList(LinkedList* list, int data) {
     Node* current = list->head;
     Node* previous = NULL;
+    int steps = 0;
 
     while (current != NULL) {
         if (current->data == data) {
@@ -80,31 +201,107 @@ void deleteLinkedList(LinkedList* list, int data) {
             } else {
                 previous->next = current->next;
             }
-            free(current);
+            releaseNode(&list->slab, current);
+            if (shouldCompactNodes(&list->slab)) {
+                compactLinkedList(list);
+            }
             return;
         }
+        if ((++steps & (COMPACT_SAMPLE_STRIDE - 1)) == 0 && current->next != NULL) {
+            noteNodeHop(&list->slab, current, current->next);
+        }
         previous = current;
         current = current->next;
     }
 }
 
+int containsLinkedList(LinkedList* list, int data) {
+    for (Node* current = list->head; current != NULL; current = current->next) {
+        if (current->data == data) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 void clearLinkedList(LinkedList* list) {
+    clearNodes(&list->slab, list->head);
+    list->head = NULL;
+}
+
+// Same as deleteLinkedList, but keeps the node two hops ahead in flight so the
+// walk overlaps its cache misses instead of paying for them one at a time.
+void deleteLinkedListPrefetch(LinkedList* list, int data) {
     Node* current = list->head;
+    Node* previous = NULL;
+    int steps = 0;
+
+    if (current != NULL) {
+        __builtin_prefetch(current->next);
+    }
     while (current != NULL) {
         Node* next = current->next;
-        free(current);
+        if (next != NULL) {
+            __builtin_prefetch(next->next);
+        }
+        if (current->data == data) {
+            if (previous == NULL) {
+                list->head = next;
+            } else {
+                previous->next = next;
+            }
+            releaseNode(&list->slab, current);
+            if (shouldCompactNodes(&list->slab)) {
+                compactLinkedList(list);
+            }
+            return;
+        }
+        if ((++steps & (COMPACT_SAMPLE_STRIDE - 1)) == 0 && next != NULL) {
+            noteNodeHop(&list->slab, current, next);
+        }
+        previous = current;
         current = next;
     }
-    list->head = NULL;
+}
+
+#define LOOKUP_BATCH 8
+
+// Looks up count keys in groups of LOOKUP_BATCH. Each group is answered by a
+// single walk that tests every node against all of the group's pending keys,
+// so the list is traversed once per group instead of once per key; the node
+// two hops ahead is prefetched while the current one is tested.
+// results[i] receives the first node holding keys[i], or NULL.
+void findLinkedListBatch(LinkedList* list, const int* keys, Node** results, int count) {
+    for (int base = 0; base < count; base += LOOKUP_BATCH) {
+        int lanes = count - base < LOOKUP_BATCH ? count - base : LOOKUP_BATCH;
+        int pending = lanes;
+
+        for (int i = 0; i < lanes; i++) {
+            results[base + i] = NULL;
+        }
+        for (Node* current = list->head; current != NULL && pending > 0; current = current->next) {
+            if (current->next != NULL) {
+                __builtin_prefetch(current->next->next);
+            }
+            for (int i = 0; i < lanes; i++) {
+                if (results[base + i] == NULL && current->data == keys[base + i]) {
+                    results[base + i] = current;
+                    pending--;
+                }
+            }
+        }
+    }
 }
 
 
 typedef struct SingleList {
     Node* head;
+    NodeSlab slab;
 } SingleList;
 
 void initSingleList(SingleList* list) {
     list->head = NULL;
+    initNodeSlab(&list->slab);
 }
 
 void insertSingleList(SingleList* list, int data) {
@@ -114,9 +311,14 @@ void insertSingleList(SingleList* list, int data) {
     list->head = newNode;
 }
 
+void compactSingleList(SingleList* list) {
+    list->head = compactNodes(&list->slab, list->head);
+}
+
 void deleteSingleList(SingleList* list, int data) {
     Node* current = list->head;
     Node* previous = NULL;
+    int steps = 0;
 
     while (current != NULL) {
         if (current->data == data) {
@@ -125,41 +327,298 @@ void deleteSingleList(SingleList* list, int data) {
             } else {
                 previous->next = current->next;
             }
-            free(current);
+            releaseNode(&list->slab, current);
+            if (shouldCompactNodes(&list->slab)) {
+                compactSingleList(list);
+            }
             return;
         }
+        if ((++steps & (COMPACT_SAMPLE_STRIDE - 1)) == 0 && current->next != NULL) {
+            noteNodeHop(&list->slab, current, current->next);
+        }
         previous = current;
         current = current->next;
     }
 }
 
-void clearSingleList(SingleList* list) {
-    Node* current = list->head;
-    while (current != NULL) {
-        Node* next = current->next;
-        free(current);
-        current = next;
+int containsSingleList(SingleList* list, int data) {
+    for (Node* current = list->head; current != NULL; current = current->next) {
+        if (current->data == data) {
+            return 1;
+        }
     }
+    return 0;
+}
+
+void clearSingleList(SingleList* list) {
+    clearNodes(&list->slab, list->head);
     list->head = NULL;
 }
 
 
+// Small-buffer storage. ArrayList and ArrayBlock keep up to SMALL_BUFFER_SIZE
+// elements inline and only spill to the heap when they outgrow it, so short
+// lists never touch the allocator. While inline, data points into the struct
+// itself: such a struct must not be copied by value.
+
+#define SMALL_BUFFER_SIZE 16
+
+int* resizeSmallBuffer(int* data, int* inlineData, int size, int capacity) {
+    if (data != inlineData) {
+        return (int*)realloc(data, capacity * sizeof(int));
+    }
+    int* heapData = (int*)malloc(capacity * sizeof(int));
+    memcpy(heapData, inlineData, size * sizeof(int));
+    return heapData;
+}
+
+
+// Snapshots. A snapshot file is one header page followed by the elements,
+// starting at the page-aligned dataOffset and zero padded to a whole page.
+// Loading maps the file and points the list straight at the mapped elements;
+// nothing is parsed or copied. SNAPSHOT_READ_ONLY maps read-only pages and the
+// first mutation copies the elements to the heap. SNAPSHOT_COPY_ON_WRITE maps
+// private writable pages, so edits stay in memory and never reach the file.
+// Growing past the mapped elements always moves them to the heap. The header
+// checksum is always checked; SNAPSHOT_VERIFY also checks the data checksum,
+// which touches every page. save and load return 0 on success and -1 on an
+// I/O error or a missing, foreign or corrupt file.
+
+#define SNAPSHOT_MAGIC 0x4b434f4c42595241ULL
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_PAGE_SIZE 4096
+
+#define SNAPSHOT_READ_ONLY 0
+#define SNAPSHOT_COPY_ON_WRITE 1
+#define SNAPSHOT_VERIFY 2
+
+enum SnapshotKind {
+    SNAPSHOT_ARRAY_LIST = 1,
+    SNAPSHOT_ARRAY_BLOCK = 2,
+    SNAPSHOT_SEGMENTED_ARRAY_BLOCK = 3
+};
+
+typedef struct SnapshotHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t kind;
+    uint64_t count;
+    uint32_t blockSize;
+    uint32_t reserved;
+    uint64_t dataOffset;
+    uint64_t dataBytes;
+    uint64_t dataChecksum;
+    uint64_t headerChecksum;
+} SnapshotHeader;
+
+typedef struct SnapshotMapping {
+    void* address;
+    size_t bytes;
+    int writable;
+} SnapshotMapping;
+
+// FNV-1a over 32-bit words, so it can be fed block by block
+uint64_t updateSnapshotChecksum(uint64_t hash, const void* data, size_t bytes) {
+    const uint32_t* words = (const uint32_t*)data;
+    for (size_t i = 0; i < bytes / sizeof(uint32_t); i++) {
+        hash ^= words[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+uint64_t snapshotChecksum(const void* data, size_t bytes) {
+    return updateSnapshotChecksum(0xcbf29ce484222325ULL, data, bytes);
+}
+
+void initSnapshotHeader(SnapshotHeader* header, uint32_t kind, uint64_t count, uint32_t blockSize, uint64_t dataBytes) {
+    memset(header, 0, sizeof(*header));
+    header->magic = SNAPSHOT_MAGIC;
+    header->version = SNAPSHOT_VERSION;
+    header->kind = kind;
+    header->count = count;
+    header->blockSize = blockSize;
+    header->dataOffset = SNAPSHOT_PAGE_SIZE;
+    header->dataBytes = dataBytes;
+}
+
+int writeSnapshot(const char* path, uint32_t kind, uint32_t blockSize, const int* data, int count) {
+    static const char zeros[SNAPSHOT_PAGE_SIZE];
+    SnapshotHeader header;
+    size_t dataBytes = (size_t)count * sizeof(int);
+    initSnapshotHeader(&header, kind, count, blockSize, dataBytes);
+    header.dataChecksum = snapshotChecksum(data, dataBytes);
+    header.headerChecksum = snapshotChecksum(&header, offsetof(SnapshotHeader, headerChecksum));
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        return -1;
+    }
+    size_t padding = (SNAPSHOT_PAGE_SIZE - dataBytes % SNAPSHOT_PAGE_SIZE) % SNAPSHOT_PAGE_SIZE;
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(zeros, SNAPSHOT_PAGE_SIZE - sizeof(header), 1, file) == 1 &&
+             fwrite(data, 1, dataBytes, file) == dataBytes &&
+             fwrite(zeros, 1, padding, file) == padding;
+    return fclose(file) == 0 && ok ? 0 : -1;
+}
+
+int mapSnapshot(const char* path, uint32_t kind, int flags, SnapshotMapping* mapping, SnapshotHeader* header) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < SNAPSHOT_PAGE_SIZE) {
+        close(fd);
+        return -1;
+    }
+    int writable = flags & SNAPSHOT_COPY_ON_WRITE;
+    void* address = mmap(NULL, info.st_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        return -1;
+    }
+
+    memcpy(header, address, sizeof(*header));
+    int valid = header->magic == SNAPSHOT_MAGIC && header->version == SNAPSHOT_VERSION && header->kind == kind &&
+                header->headerChecksum == snapshotChecksum(header, offsetof(SnapshotHeader, headerChecksum)) &&
+                header->dataOffset % SNAPSHOT_PAGE_SIZE == 0 &&
+                header->dataOffset + header->dataBytes <= (uint64_t)info.st_size &&
+                header->count <= header->dataBytes / sizeof(int) && header->count <= INT32_MAX;
+    if (valid && (flags & SNAPSHOT_VERIFY)) {
+        valid = snapshotChecksum((char*)address + header->dataOffset, header->dataBytes) == header->dataChecksum;
+    }
+    if (!valid) {
+        munmap(address, info.st_size);
+        return -1;
+    }
+    mapping->address = address;
+    mapping->bytes = info.st_size;
+    mapping->writable = writable;
+    return 0;
+}
+
+void initSnapshotMapping(SnapshotMapping* mapping) {
+    mapping->address = NULL;
+    mapping->bytes = 0;
+    mapping->writable = 0;
+}
+
+void unmapSnapshot(SnapshotMapping* mapping) {
+    if (mapping->address != NULL) {
+        munmap(mapping->address, mapping->bytes);
+    }
+    initSnapshotMapping(mapping);
+}
+
+// Moves mapped elements to a heap buffer of the given capacity and unmaps
+int* detachSnapshot(SnapshotMapping* mapping, const int* data, int size, int capacity) {
+    int* heapData = (int*)malloc(capacity * sizeof(int));
+    memcpy(heapData, data, size * sizeof(int));
+    unmapSnapshot(mapping);
+    return heapData;
+}
+
+// LSD radix sort over 8-bit digits, with the sign bit flipped so negative
+// values order first. All digit histograms come from one read pass, and a
+// pass is skipped when every key shares its digit.
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES ((int)(sizeof(int) * 8 / RADIX_BITS))
+#define SORT_UNIQUE 1
+
+void radixSortInts(int* data, int* scratch, size_t count) {
+    size_t histogram[RADIX_PASSES][RADIX_BUCKETS];
+    memset(histogram, 0, sizeof(histogram));
+    for (size_t i = 0; i < count; i++) {
+        uint32_t key = (uint32_t)data[i] ^ 0x80000000u;
+        for (int pass = 0; pass < RADIX_PASSES; pass++) {
+            histogram[pass][(key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+        }
+    }
+
+    int* from = data;
+    int* to = scratch;
+    for (int pass = 0; count > 0 && pass < RADIX_PASSES; pass++) {
+        int shift = pass * RADIX_BITS;
+        size_t* bucket = histogram[pass];
+        if (bucket[(((uint32_t)from[0] ^ 0x80000000u) >> shift) & (RADIX_BUCKETS - 1)] == count) {
+            continue;
+        }
+        size_t offset = 0;
+        for (int b = 0; b < RADIX_BUCKETS; b++) {
+            size_t n = bucket[b];
+            bucket[b] = offset;
+            offset += n;
+        }
+        for (size_t i = 0; i < count; i++) {
+            uint32_t key = (uint32_t)from[i] ^ 0x80000000u;
+            to[bucket[(key >> shift) & (RADIX_BUCKETS - 1)]++] = from[i];
+        }
+        int* swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != data) {
+        memcpy(data, from, count * sizeof(int));
+    }
+}
+
+// Sorts size elements ascending in place and returns the new size, which is
+// smaller only when SORT_UNIQUE drops repeats
+int sortInts(int* data, int size, int flags) {
+    if (size < 2) {
+        return size;
+    }
+    int* scratch = (int*)malloc(size * sizeof(int));
+    if (!scratch) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    radixSortInts(data, scratch, size);
+    free(scratch);
+    if (!(flags & SORT_UNIQUE)) {
+        return size;
+    }
+    int kept = 1;
+    for (int i = 1; i < size; i++) {
+        if (data[i] != data[kept - 1]) {
+            data[kept++] = data[i];
+        }
+    }
+    return kept;
+}
+
+
 typedef struct ArrayList {
     int* data;
     int capacity;
     int size;
+    int inlineData[SMALL_BUFFER_SIZE];
+    SnapshotMapping snapshot;
 } ArrayList;
 
 void initArrayList(ArrayList* list, int capacity) {
-    list->data = (int*)malloc(capacity * sizeof(int));
-    list->capacity = capacity;
+    if (capacity <= SMALL_BUFFER_SIZE) {
+        list->data = list->inlineData;
+        list->capacity = SMALL_BUFFER_SIZE;
+    } else {
+        list->data = (int*)malloc(capacity * sizeof(int));
+        list->capacity = capacity;
+    }
     list->size = 0;
+    initSnapshotMapping(&list->snapshot);
 }
 
 void insertArrayList(ArrayList* list, int data) {
     if (list->size == list->capacity) {
-        list->capacity *= 2;
-        list->data = (int*)realloc(list->data, list->capacity * sizeof(int));
+        if (list->snapshot.address != NULL) {
+            list->capacity = list->capacity > SMALL_BUFFER_SIZE ? list->capacity * 2 : SMALL_BUFFER_SIZE * 2;
+            list->data = detachSnapshot(&list->snapshot, list->data, list->size, list->capacity);
+        } else {
+            list->capacity *= 2;
+            list->data = resizeSmallBuffer(list->data, list->inlineData, list->size, list->capacity);
+        }
     }
     list->data[list->size++] = data;
 }
@@ -167,6 +626,9 @@ void insertArrayList(ArrayList* list, int data) {
 void deleteArrayList(ArrayList* list, int data) {
     for (int i = 0; i < list->size; i++) {
         if (list->data[i] == data) {
+            if (list->snapshot.address != NULL && !list->snapshot.writable) {
+                list->data = detachSnapshot(&list->snapshot, list->data, list->size, list->capacity);
+            }
             for (int j = i; j < list->size - 1; j++) {
                 list->data[j] = list->data[j + 1];
             }
@@ -176,13 +638,52 @@ void deleteArrayList(ArrayList* list, int data) {
     }
 }
 
+int containsArrayList(ArrayList* list, int data) {
+    for (int i = 0; i < list->size; i++) {
+        if (list->data[i] == data) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 void clearArrayList(ArrayList* list) {
-    free(list->data);
-    list->data = NULL;
-    list->capacity = 0;
+    if (list->snapshot.address != NULL) {
+        unmapSnapshot(&list->snapshot);
+    } else if (list->data != list->inlineData) {
+        free(list->data);
+    }
+    list->data = list->inlineData;
+    list->capacity = SMALL_BUFFER_SIZE;
     list->size = 0;
 }
 
+void sortArrayList(ArrayList* list, int flags) {
+    if (list->size > 1 && list->snapshot.address != NULL && !list->snapshot.writable) {
+        list->data = detachSnapshot(&list->snapshot, list->data, list->size, list->capacity);
+    }
+    list->size = sortInts(list->data, list->size, flags);
+}
+
+int saveArrayList(ArrayList* list, const char* path) {
+    return writeSnapshot(path, SNAPSHOT_ARRAY_LIST, 0, list->data, list->size);
+}
+
+// list must be initialised; its previous contents are released
+int loadArrayList(ArrayList* list, const char* path, int flags) {
+    SnapshotMapping mapping;
+    SnapshotHeader header;
+    if (mapSnapshot(path, SNAPSHOT_ARRAY_LIST, flags, &mapping, &header) != 0) {
+        return -1;
+    }
+    clearArrayList(list);
+    list->snapshot = mapping;
+    list->data = (int*)((char*)mapping.address + header.dataOffset);
+    list->size = (int)header.count;
+    list->capacity = (int)header.count;
+    return 0;
+}
+
 
 typedef struct ArrayRing {
     int* data;
@@ -223,12 +724,22 @@ void deleteArrayRing(ArrayRing* ring, int data) {
             for (int j = i; j < ring->size - 1; j++) {
                 ring->data[(ring->head + j) % ring->capacity] = ring->data[(ring->head + j + 1) % ring->capacity];
             }
+            ring->tail = (ring->tail + ring->capacity - 1) % ring->capacity;
             ring->size--;
             return;
         }
     }
 }
 
+int containsArrayRing(ArrayRing* ring, int data) {
+    for (int i = 0; i < ring->size; i++) {
+        if (ring->data[(ring->head + i) % ring->capacity] == data) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 void clearArrayRing(ArrayRing* ring) {
     free(ring->data);
     ring->data = NULL;
@@ -239,24 +750,220 @@ void clearArrayRing(ArrayRing* ring) {
 }
 
 
+// Lock-free bounded queues derived from ArrayRing. Both keep ArrayRing's
+// head/tail ring mechanics but use free-running indices over a power-of-two
+// capacity, so wrap-around is a mask instead of a modulo.
+
+#define CACHE_LINE_SIZE 64
+
+size_t roundUpPowerOfTwo(int capacity) {
+    size_t result = 1;
+    while (result < (size_t)capacity) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// Single producer, single consumer. head is only written by the consumer and
+// tail only by the producer; each sits on its own cache line next to the
+// owner's cached copy of the other index, so the fast path touches no shared
+// line. Publication uses release stores and acquire loads.
+typedef struct SpscArrayRing {
+    int* data;
+    size_t mask;
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t head;
+    size_t cachedTail;
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t tail;
+    size_t cachedHead;
+    _Alignas(CACHE_LINE_SIZE) char padding;
+} SpscArrayRing;
+
+void initSpscArrayRing(SpscArrayRing* ring, int capacity) {
+    size_t size = roundUpPowerOfTwo(capacity);
+    ring->data = (int*)malloc(size * sizeof(int));
+    ring->mask = size - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->cachedTail = 0;
+    ring->cachedHead = 0;
+}
+
+// Pushes up to count values and returns how many fit
+int pushBatchSpscArrayRing(SpscArrayRing* ring, const int* data, int count) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t capacity = ring->mask + 1;
+    if (capacity - (tail - ring->cachedHead) < (size_t)count) {
+        ring->cachedHead = atomic_load_explicit(&ring->head, memory_order_acquire);
+    }
+    size_t space = capacity - (tail - ring->cachedHead);
+    int n = space < (size_t)count ? (int)space : count;
+    for (int i = 0; i < n; i++) {
+        ring->data[(tail + i) & ring->mask] = data[i];
+    }
+    atomic_store_explicit(&ring->tail, tail + n, memory_order_release);
+    return n;
+}
+
+// Pops up to count values and returns how many were available
+int popBatchSpscArrayRing(SpscArrayRing* ring, int* data, int count) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (ring->cachedTail - head < (size_t)count) {
+        ring->cachedTail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    }
+    size_t available = ring->cachedTail - head;
+    int n = available < (size_t)count ? (int)available : count;
+    for (int i = 0; i < n; i++) {
+        data[i] = ring->data[(head + i) & ring->mask];
+    }
+    atomic_store_explicit(&ring->head, head + n, memory_order_release);
+    return n;
+}
+
+int pushSpscArrayRing(SpscArrayRing* ring, int data) {
+    return pushBatchSpscArrayRing(ring, &data, 1) == 1;
+}
+
+int popSpscArrayRing(SpscArrayRing* ring, int* data) {
+    return popBatchSpscArrayRing(ring, data, 1) == 1;
+}
+
+void clearSpscArrayRing(SpscArrayRing* ring) {
+    free(ring->data);
+    ring->data = NULL;
+    ring->mask = 0;
+}
+
+// Multi producer, multi consumer (Vyukov). Every slot carries a sequence
+// number: a slot at position pos is free for a producer when its sequence is
+// pos and holds data for a consumer when it is pos + 1. Producers and
+// consumers claim positions by CAS on their own padded counter; a batch
+// claims a run of consecutive positions whose slots are already ready. A
+// single slot cannot tell "full at pos" from "free at pos + 1", so the ring
+// always has at least MPMC_MIN_CAPACITY slots.
+#define MPMC_MIN_CAPACITY 2
+
+typedef struct MpmcSlot {
+    atomic_size_t sequence;
+    int data;
+} MpmcSlot;
+
+typedef struct MpmcArrayRing {
+    MpmcSlot* slots;
+    size_t mask;
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t enqueuePos;
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t dequeuePos;
+    _Alignas(CACHE_LINE_SIZE) char padding;
+} MpmcArrayRing;
+
+void initMpmcArrayRing(MpmcArrayRing* ring, int capacity) {
+    size_t size = roundUpPowerOfTwo(capacity < MPMC_MIN_CAPACITY ? MPMC_MIN_CAPACITY : capacity);
+    ring->slots = (MpmcSlot*)malloc(size * sizeof(MpmcSlot));
+    if (ring->slots == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&ring->slots[i].sequence, i);
+    }
+    ring->mask = size - 1;
+    atomic_init(&ring->enqueuePos, 0);
+    atomic_init(&ring->dequeuePos, 0);
+}
+
+// Claims up to count consecutive positions starting at *position whose slots
+// have sequence position + i + offset. Returns 0 when the ring is full (or
+// empty, for consumers).
+int claimMpmcArrayRing(MpmcArrayRing* ring, atomic_size_t* counter, size_t offset, int count, size_t* position) {
+    size_t pos = atomic_load_explicit(counter, memory_order_relaxed);
+    for (;;) {
+        int n = 0;
+        while (n < count) {
+            size_t sequence = atomic_load_explicit(&ring->slots[(pos + n) & ring->mask].sequence, memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + n + offset);
+            if (diff != 0) {
+                if (n == 0 && diff < 0) {
+                    return 0;
+                }
+                break;
+            }
+            n++;
+        }
+        if (n == 0) {
+            pos = atomic_load_explicit(counter, memory_order_relaxed);
+        } else if (atomic_compare_exchange_weak_explicit(counter, &pos, pos + n,
+                                                         memory_order_relaxed, memory_order_relaxed)) {
+            *position = pos;
+            return n;
+        }
+    }
+}
+
+int pushBatchMpmcArrayRing(MpmcArrayRing* ring, const int* data, int count) {
+    size_t pos;
+    int n = claimMpmcArrayRing(ring, &ring->enqueuePos, 0, count, &pos);
+    for (int i = 0; i < n; i++) {
+        MpmcSlot* slot = &ring->slots[(pos + i) & ring->mask];
+        slot->data = data[i];
+        atomic_store_explicit(&slot->sequence, pos + i + 1, memory_order_release);
+    }
+    return n;
+}
+
+int popBatchMpmcArrayRing(MpmcArrayRing* ring, int* data, int count) {
+    size_t pos;
+    int n = claimMpmcArrayRing(ring, &ring->dequeuePos, 1, count, &pos);
+    for (int i = 0; i < n; i++) {
+        MpmcSlot* slot = &ring->slots[(pos + i) & ring->mask];
+        data[i] = slot->data;
+        atomic_store_explicit(&slot->sequence, pos + i + ring->mask + 1, memory_order_release);
+    }
+    return n;
+}
+
+int pushMpmcArrayRing(MpmcArrayRing* ring, int data) {
+    return pushBatchMpmcArrayRing(ring, &data, 1) == 1;
+}
+
+int popMpmcArrayRing(MpmcArrayRing* ring, int* data) {
+    return popBatchMpmcArrayRing(ring, data, 1) == 1;
+}
+
+void clearMpmcArrayRing(MpmcArrayRing* ring) {
+    free(ring->slots);
+    ring->slots = NULL;
+    ring->mask = 0;
+}
+
 typedef struct ArrayBlock {
     int* data;
     int capacity;
     int size;
     int blockSize;
+    int inlineData[SMALL_BUFFER_SIZE];
+    SnapshotMapping snapshot;
 } ArrayBlock;
 
 void initArrayBlock(ArrayBlock* block, int capacity, int blockSize) {
-    block->data = (int*)malloc(capacity * sizeof(int));
-    block->capacity = capacity;
+    if (capacity <= SMALL_BUFFER_SIZE) {
+        block->data = block->inlineData;
+        block->capacity = SMALL_BUFFER_SIZE;
+    } else {
+        block->data = (int*)malloc(capacity * sizeof(int));
+        block->capacity = capacity;
+    }
     block->size = 0;
     block->blockSize = blockSize;
+    initSnapshotMapping(&block->snapshot);
 }
 
 void insertArrayBlock(ArrayBlock* block, int data) {
     if (block->size == block->capacity) {
         block->capacity += block->blockSize;
-        block->data = (int*)realloc(block->data, block->capacity * sizeof(int));
+        if (block->snapshot.address != NULL) {
+            block->data = detachSnapshot(&block->snapshot, block->data, block->size, block->capacity);
+        } else {
+            block->data = resizeSmallBuffer(block->data, block->inlineData, block->size, block->capacity);
+        }
     }
     block->data[block->size++] = data;
 }
@@ -264,6 +971,9 @@ void insertArrayBlock(ArrayBlock* block, int data) {
 void deleteArrayBlock(ArrayBlock* block, int data) {
     for (int i = 0; i < block->size; i++) {
         if (block->data[i] == data) {
+            if (block->snapshot.address != NULL && !block->snapshot.writable) {
+                block->data = detachSnapshot(&block->snapshot, block->data, block->size, block->capacity);
+            }
             for (int j = i; j < block->size - 1; j++) {
                 block->data[j] = block->data[j + 1];
             }
@@ -273,14 +983,347 @@ void deleteArrayBlock(ArrayBlock* block, int data) {
     }
 }
 
+int containsArrayBlock(ArrayBlock* block, int data) {
+    for (int i = 0; i < block->size; i++) {
+        if (block->data[i] == data) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 void clearArrayBlock(ArrayBlock* block) {
-    free(block->data);
-    block->data = NULL;
-    block->capacity = 0;
+    if (block->snapshot.address != NULL) {
+        unmapSnapshot(&block->snapshot);
+    } else if (block->data != block->inlineData) {
+        free(block->data);
+    }
+    block->data = block->inlineData;
+    block->capacity = SMALL_BUFFER_SIZE;
     block->size = 0;
     block->blockSize = 0;
 }
 
+void sortArrayBlock(ArrayBlock* block, int flags) {
+    if (block->size > 1 && block->snapshot.address != NULL && !block->snapshot.writable) {
+        block->data = detachSnapshot(&block->snapshot, block->data, block->size, block->capacity);
+    }
+    block->size = sortInts(block->data, block->size, flags);
+}
+
+int saveArrayBlock(ArrayBlock* block, const char* path) {
+    return writeSnapshot(path, SNAPSHOT_ARRAY_BLOCK, block->blockSize, block->data, block->size);
+}
+
+// block must be initialised; its previous contents are released
+int loadArrayBlock(ArrayBlock* block, const char* path, int flags) {
+    SnapshotMapping mapping;
+    SnapshotHeader header;
+    if (mapSnapshot(path, SNAPSHOT_ARRAY_BLOCK, flags, &mapping, &header) != 0) {
+        return -1;
+    }
+    clearArrayBlock(block);
+    block->snapshot = mapping;
+    block->data = (int*)((char*)mapping.address + header.dataOffset);
+    block->size = (int)header.count;
+    block->capacity = (int)header.count;
+    block->blockSize = header.blockSize > 0 ? (int)header.blockSize : SMALL_BUFFER_SIZE;
+    return 0;
+}
+
+
+// Thread pool. A fixed set of workers that all run the same task once per
+// runThreadPool call, each with its own index, and then report back.
+
+typedef struct ThreadPool {
+    pthread_t* threads;
+    int numThreads;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    void (*task)(void*, int, int);
+    void* arg;
+    long generation;
+    int pending;
+    int stopping;
+} ThreadPool;
+
+typedef struct ThreadPoolWorker {
+    ThreadPool* pool;
+    int index;
+} ThreadPoolWorker;
+
+void* threadPoolWorker(void* arg) {
+    ThreadPoolWorker* worker = (ThreadPoolWorker*)arg;
+    ThreadPool* pool = worker->pool;
+    long seen = 0;
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == seen && !pool->stopping) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->stopping) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        pool->task(pool->arg, worker->index, pool->numThreads);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    free(worker);
+    return NULL;
+}
+
+void initThreadPool(ThreadPool* pool, int numThreads) {
+    pool->threads = (pthread_t*)malloc(numThreads * sizeof(pthread_t));
+    if (!pool->threads) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    pool->numThreads = numThreads;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->task = NULL;
+    pool->arg = NULL;
+    pool->generation = 0;
+    pool->pending = 0;
+    pool->stopping = 0;
+    for (int i = 0; i < numThreads; i++) {
+        ThreadPoolWorker* worker = (ThreadPoolWorker*)malloc(sizeof(ThreadPoolWorker));
+        if (!worker) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+        worker->pool = pool;
+        worker->index = i;
+        pthread_create(&pool->threads[i], NULL, threadPoolWorker, worker);
+    }
+}
+
+// Runs task(arg, index, numThreads) on every worker and waits for all of them
+void runThreadPool(ThreadPool* pool, void (*task)(void*, int, int), void* arg) {
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->pending = pool->numThreads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void destroyThreadPool(ThreadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->numThreads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+    pool->threads = NULL;
+    pool->numThreads = 0;
+}
+
+
+// Parallel scans over the flat ArrayBlock. The elements are split into one
+// contiguous range per worker of a caller-owned thread pool; find and count
+// combine per-worker partial results, and removeIf counts survivors per
+// range, prefix-sums the counts into output offsets and lets each worker copy
+// its survivors into place in a fresh buffer. Blocks below
+// PARALLEL_MIN_ELEMENTS, or a NULL thread pool, run on the calling thread,
+// and removeIf then compacts in place.
+
+#define PARALLEL_MIN_ELEMENTS 65536
+#define MAX_PARALLEL_THREADS 64
+
+typedef struct ParallelScan {
+    ArrayBlock* block;
+    int workers;
+    int value;
+    int (*predicate)(int, void*);
+    void* predicateArg;
+    int* out;
+    long partial[MAX_PARALLEL_THREADS];
+    long offset[MAX_PARALLEL_THREADS];
+} ParallelScan;
+
+int parallelWorkers(ThreadPool* threadPool, ArrayBlock* block) {
+    if (threadPool == NULL || block->size < PARALLEL_MIN_ELEMENTS) {
+        return 1;
+    }
+    return threadPool->numThreads < MAX_PARALLEL_THREADS ? threadPool->numThreads : MAX_PARALLEL_THREADS;
+}
+
+void runParallelScan(ThreadPool* threadPool, int workers, void (*task)(void*, int, int), ParallelScan* scan) {
+    scan->workers = workers;
+    if (workers == 1) {
+        task(scan, 0, 1);
+    } else {
+        runThreadPool(threadPool, task, scan);
+    }
+}
+
+void elementRange(ParallelScan* scan, int index, int* first, int* last) {
+    int size = scan->block->size;
+    *first = (int)((long)size * index / scan->workers);
+    *last = (int)((long)size * (index + 1) / scan->workers);
+}
+
+void findRange(void* arg, int index, int numThreads) {
+    ParallelScan* scan = (ParallelScan*)arg;
+    int first, last;
+    (void)numThreads;
+    if (index >= scan->workers) return;
+    elementRange(scan, index, &first, &last);
+    const int* data = scan->block->data;
+    scan->partial[index] = -1;
+    for (int i = first; i < last; i++) {
+        if (data[i] == scan->value) {
+            scan->partial[index] = i;
+            return;
+        }
+    }
+}
+
+// Index of the first occurrence of data, or -1
+long findArrayBlockParallel(ThreadPool* threadPool, ArrayBlock* block, int data) {
+    ParallelScan scan;
+    scan.block = block;
+    scan.value = data;
+    int workers = parallelWorkers(threadPool, block);
+    runParallelScan(threadPool, workers, findRange, &scan);
+    for (int t = 0; t < workers; t++) {
+        if (scan.partial[t] >= 0) {
+            return scan.partial[t];
+        }
+    }
+    return -1;
+}
+
+void countRange(void* arg, int index, int numThreads) {
+    ParallelScan* scan = (ParallelScan*)arg;
+    int first, last;
+    (void)numThreads;
+    if (index >= scan->workers) return;
+    elementRange(scan, index, &first, &last);
+    const int* data = scan->block->data;
+    long count = 0;
+    for (int i = first; i < last; i++) {
+        count += data[i] == scan->value;
+    }
+    scan->partial[index] = count;
+}
+
+long countArrayBlockParallel(ThreadPool* threadPool, ArrayBlock* block, int data) {
+    ParallelScan scan;
+    scan.block = block;
+    scan.value = data;
+    int workers = parallelWorkers(threadPool, block);
+    runParallelScan(threadPool, workers, countRange, &scan);
+    long count = 0;
+    for (int t = 0; t < workers; t++) {
+        count += scan.partial[t];
+    }
+    return count;
+}
+
+void keepCountRange(void* arg, int index, int numThreads) {
+    ParallelScan* scan = (ParallelScan*)arg;
+    int first, last;
+    (void)numThreads;
+    if (index >= scan->workers) return;
+    elementRange(scan, index, &first, &last);
+    const int* data = scan->block->data;
+    long kept = 0;
+    for (int i = first; i < last; i++) {
+        kept += !scan->predicate(data[i], scan->predicateArg);
+    }
+    scan->partial[index] = kept;
+}
+
+void keepCopyRange(void* arg, int index, int numThreads) {
+    ParallelScan* scan = (ParallelScan*)arg;
+    int first, last;
+    (void)numThreads;
+    if (index >= scan->workers) return;
+    elementRange(scan, index, &first, &last);
+    const int* data = scan->block->data;
+    int* out = scan->out + scan->offset[index];
+    for (int i = first; i < last; i++) {
+        if (!scan->predicate(data[i], scan->predicateArg)) {
+            *out++ = data[i];
+        }
+    }
+}
+
+// Removes every element matching predicate, keeping the order of the rest;
+// returns the number of elements removed
+int removeIfArrayBlockParallel(ThreadPool* threadPool, ArrayBlock* block, int (*predicate)(int, void*), void* predicateArg) {
+    int workers = parallelWorkers(threadPool, block);
+    if (workers == 1) {
+        int kept = 0;
+        for (int i = 0; i < block->size; i++) {
+            if (predicate(block->data[i], predicateArg)) {
+                continue;
+            }
+            if (kept < i) {
+                if (block->snapshot.address != NULL && !block->snapshot.writable) {
+                    block->data = detachSnapshot(&block->snapshot, block->data, block->size, block->capacity);
+                }
+                block->data[kept] = block->data[i];
+            }
+            kept++;
+        }
+        int removed = block->size - kept;
+        block->size = kept;
+        return removed;
+    }
+
+    ParallelScan scan;
+    scan.block = block;
+    scan.predicate = predicate;
+    scan.predicateArg = predicateArg;
+    runParallelScan(threadPool, workers, keepCountRange, &scan);
+    long kept = 0;
+    for (int t = 0; t < workers; t++) {
+        scan.offset[t] = kept;
+        kept += scan.partial[t];
+    }
+    int removed = block->size - (int)kept;
+    if (removed == 0) {
+        return 0;
+    }
+
+    scan.out = (int*)malloc(block->capacity * sizeof(int));
+    if (scan.out == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    runParallelScan(threadPool, workers, keepCopyRange, &scan);
+    if (block->snapshot.address != NULL) {
+        unmapSnapshot(&block->snapshot);
+    } else if (block->data != block->inlineData) {
+        free(block->data);
+    }
+    block->data = scan.out;
+    block->size = (int)kept;
+    return removed;
+}
+
 
 void stroustrupBenchmark(void* list, void (*insert)(void*, int), void (*delete)(void*, int), int n) {
     for (int i = 0; i < n; i++) {
@@ -295,6 +1338,7 @@ void benchmarkStroustrup() {
     const int n = 1000000;
     NoCacheList noCacheList;
     LinkedList linkedList;
+    LinkedList prefetchList;
     SingleList singleList;
     ArrayList arrayList;
     ArrayRing arrayRing;
@@ -302,6 +1346,7 @@ void benchmarkStroustrup() {
 
     initNoCacheList(&noCacheList);
     initLinkedList(&linkedList);
+    initLinkedList(&prefetchList);
     initSingleList(&singleList);
     initArrayList(&arrayList, 1000);
     initArrayRing(&arrayRing, 1000);
@@ -322,6 +1367,12 @@ void benchmarkStroustrup() {
     time_spent = (double)(end - start) / CLOCKS_PER_SEC;
     printf("LinkedList: %f seconds\n", time_spent);
 
+    start = clock();
+    stroustrupBenchmark(&prefetchList, (void (*)(void*, int))insertLinkedList, (void (*)(void*, int))deleteLinkedListPrefetch, n);
+    end = clock();
+    time_spent = (double)(end - start) / CLOCKS_PER_SEC;
+    printf("LinkedList (prefetch): %f seconds\n", time_spent);
+
     start = clock();
     stroustrupBenchmark(&singleList, (void (*)(void*, int))insertSingleList, (void (*)(void*, int))deleteSingleList, n);
     end = clock();
@@ -348,6 +1399,7 @@ void benchmarkStroustrup() {
 
     clearNoCacheList(&noCacheList);
     clearLinkedList(&linkedList);
+    clearLinkedList(&prefetchList);
     clearSingleList(&singleList);
     clearArrayList(&arrayList);
     clearArrayRing(&arrayRing);
@@ -368,6 +1420,7 @@ void benchmarkFairbench() {
     const int n = 1000000;
     NoCacheList noCacheList;
     LinkedList linkedList;
+    LinkedList prefetchList;
     SingleList singleList;
     ArrayList arrayList;
     ArrayRing arrayRing;
@@ -375,6 +1428,7 @@ void benchmarkFairbench() {
 
     initNoCacheList(&noCacheList);
     initLinkedList(&linkedList);
+    initLinkedList(&prefetchList);
     initSingleList(&singleList);
     initArrayList(&arrayList, 1000);
     initArrayRing(&arrayRing, 1000);
@@ -395,6 +1449,12 @@ void benchmarkFairbench() {
     time_spent = (double)(end - start) / CLOCKS_PER_SEC;
     printf("LinkedList: %f seconds\n", time_spent);
 
+    start = clock();
+    fairbench(&prefetchList, (void (*)(void*, int))insertLinkedList, (void (*)(void*, int))deleteLinkedListPrefetch, n);
+    end = clock();
+    time_spent = (double)(end - start) / CLOCKS_PER_SEC;
+    printf("LinkedList (prefetch): %f seconds\n", time_spent);
+
     start = clock();
     fairbench(&singleList, (void (*)(void*, int))insertSingleList, (void (*)(void*, int))deleteSingleList, n);
     end = clock();
@@ -421,6 +1481,7 @@ void benchmarkFairbench() {
 
     clearNoCacheList(&noCacheList);
     clearLinkedList(&linkedList);
+    clearLinkedList(&prefetchList);
     clearSingleList(&singleList);
     clearArrayList(&arrayList);
     clearArrayRing(&arrayRing);
@@ -428,6 +1489,505 @@ void benchmarkFairbench() {
 }
 
 
+// Lookups of random keys in a list built by insertLinkedList, one key per
+// walk against LOOKUP_BATCH keys per walk
+void benchmarkBatchLookup() {
+    const int n = 100000;
+    const int numLookups = 4096;
+    int* keys = (int*)malloc(numLookups * sizeof(int));
+    Node** results = (Node**)malloc(numLookups * sizeof(Node*));
+    if (keys == NULL || results == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    LinkedList list;
+    initLinkedList(&list);
+    for (int i = 0; i < n; i++) {
+        insertLinkedList(&list, i);
+    }
+    for (int i = 0; i < numLookups; i++) {
+        keys[i] = rand() % n;
+    }
+
+    clock_t start = clock();
+    int found = 0;
+    for (int i = 0; i < numLookups; i++) {
+        found += containsLinkedList(&list, keys[i]);
+    }
+    clock_t end = clock();
+    printf("LinkedList lookups (single, %d found): %f seconds\n", found, (double)(end - start) / CLOCKS_PER_SEC);
+
+    start = clock();
+    findLinkedListBatch(&list, keys, results, numLookups);
+    end = clock();
+    found = 0;
+    for (int i = 0; i < numLookups; i++) {
+        found += results[i] != NULL;
+    }
+    printf("LinkedList lookups (batch of %d, %d found): %f seconds\n", LOOKUP_BATCH, found, (double)(end - start) / CLOCKS_PER_SEC);
+
+    clearLinkedList(&list);
+    free(keys);
+    free(results);
+}
+
+
+// Ring queue throughput. Producers push RING_BENCH_ITEMS values in total in
+// batches of RING_BENCH_BATCH; consumers pop until all are drained. The sum
+// of popped values is checked so a lost or duplicated item fails loudly.
+
+#define RING_BENCH_ITEMS (1 << 22)
+#define RING_BENCH_BATCH 32
+#define RING_BENCH_CAPACITY 4096
+#define RING_BENCH_MAX_THREADS 8
+
+typedef struct RingBenchShared {
+    void* ring;
+    int (*pushBatch)(void*, const int*, int);
+    int (*popBatch)(void*, int*, int);
+    int itemsPerProducer;
+    long total;
+    atomic_long consumed;
+    atomic_llong sum;
+} RingBenchShared;
+
+typedef struct RingBenchTask {
+    RingBenchShared* shared;
+    int first;
+} RingBenchTask;
+
+double wallSeconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+void* ringBenchProducer(void* arg) {
+    RingBenchTask* task = (RingBenchTask*)arg;
+    RingBenchShared* shared = task->shared;
+    int batch[RING_BENCH_BATCH];
+    int next = task->first;
+    int end = task->first + shared->itemsPerProducer;
+    while (next < end) {
+        int count = end - next < RING_BENCH_BATCH ? end - next : RING_BENCH_BATCH;
+        for (int i = 0; i < count; i++) {
+            batch[i] = next + i;
+        }
+        int pushed = 0;
+        while (pushed < count) {
+            int n = shared->pushBatch(shared->ring, batch + pushed, count - pushed);
+            if (n == 0) {
+                sched_yield();
+            }
+            pushed += n;
+        }
+        next += count;
+    }
+    return NULL;
+}
+
+void* ringBenchConsumer(void* arg) {
+    RingBenchTask* task = (RingBenchTask*)arg;
+    RingBenchShared* shared = task->shared;
+    int batch[RING_BENCH_BATCH];
+    long long sum = 0;
+    while (atomic_load_explicit(&shared->consumed, memory_order_relaxed) < shared->total) {
+        int n = shared->popBatch(shared->ring, batch, RING_BENCH_BATCH);
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+        for (int i = 0; i < n; i++) {
+            sum += batch[i];
+        }
+        atomic_fetch_add_explicit(&shared->consumed, n, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&shared->sum, sum, memory_order_relaxed);
+    return NULL;
+}
+
+double ringBenchmark(void* ring, int (*pushBatch)(void*, const int*, int), int (*popBatch)(void*, int*, int), int producers, int consumers) {
+    RingBenchShared shared;
+    shared.ring = ring;
+    shared.pushBatch = pushBatch;
+    shared.popBatch = popBatch;
+    shared.itemsPerProducer = RING_BENCH_ITEMS / producers;
+    shared.total = (long)shared.itemsPerProducer * producers;
+    atomic_init(&shared.consumed, 0);
+    atomic_init(&shared.sum, 0);
+
+    pthread_t threads[2 * RING_BENCH_MAX_THREADS];
+    RingBenchTask tasks[2 * RING_BENCH_MAX_THREADS];
+    double start = wallSeconds();
+    for (int i = 0; i < producers + consumers; i++) {
+        tasks[i].shared = &shared;
+        tasks[i].first = i * shared.itemsPerProducer;
+        pthread_create(&threads[i], NULL, i < producers ? ringBenchProducer : ringBenchConsumer, &tasks[i]);
+    }
+    for (int i = 0; i < producers + consumers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = wallSeconds() - start;
+
+    long long expected = (long long)(shared.total - 1) * shared.total / 2;
+    if (atomic_load(&shared.sum) != expected) {
+        fprintf(stderr, "Ring queue lost or duplicated items\n");
+        exit(1);
+    }
+    return shared.total / elapsed / 1e6;
+}
+
+// Fills and drains the smallest MPMC rings on one thread; returns 0 if an
+// item is lost, duplicated, reordered or accepted past capacity
+int checkSmallMpmcArrayRings() {
+    for (int capacity = 0; capacity <= 4; capacity++) {
+        MpmcArrayRing ring;
+        initMpmcArrayRing(&ring, capacity);
+        int slots = (int)ring.mask + 1;
+        for (int round = 0; round < 3; round++) {
+            int pushed = 0;
+            while (pushMpmcArrayRing(&ring, round * 100 + pushed)) {
+                if (++pushed > slots) {
+                    clearMpmcArrayRing(&ring);
+                    return 0;
+                }
+            }
+            int value;
+            for (int i = 0; i < pushed; i++) {
+                if (!popMpmcArrayRing(&ring, &value) || value != round * 100 + i) {
+                    clearMpmcArrayRing(&ring);
+                    return 0;
+                }
+            }
+            if (pushed != slots || popMpmcArrayRing(&ring, &value)) {
+                clearMpmcArrayRing(&ring);
+                return 0;
+            }
+        }
+        clearMpmcArrayRing(&ring);
+    }
+    return 1;
+}
+
+void benchmarkRingQueues() {
+    printf("MpmcArrayRing small-capacity check: %s\n", checkSmallMpmcArrayRings() ? "ok" : "FAILED");
+
+    SpscArrayRing spsc;
+    initSpscArrayRing(&spsc, RING_BENCH_CAPACITY);
+    printf("SpscArrayRing 1P/1C: %f Mitems/s\n",
+           ringBenchmark(&spsc, (int (*)(void*, const int*, int))pushBatchSpscArrayRing,
+                         (int (*)(void*, int*, int))popBatchSpscArrayRing, 1, 1));
+    clearSpscArrayRing(&spsc);
+
+    for (int threads = 1; threads <= RING_BENCH_MAX_THREADS; threads *= 2) {
+        MpmcArrayRing mpmc;
+        initMpmcArrayRing(&mpmc, RING_BENCH_CAPACITY);
+        printf("MpmcArrayRing %dP/%dC: %f Mitems/s\n", threads, threads,
+               ringBenchmark(&mpmc, (int (*)(void*, const int*, int))pushBatchMpmcArrayRing,
+                             (int (*)(void*, int*, int))popBatchMpmcArrayRing, threads, threads));
+        clearMpmcArrayRing(&mpmc);
+    }
+}
+
+
+// Multi-threaded contention benchmark. T pinned threads run a mixed workload
+// against one structure: CONTENTION_READ_PERCENT% contains, the rest split
+// between insert and delete, over CONTENTION_KEY_RANGE keys. Three sharing
+// strategies are compared:
+//   mutex   - one global mutex around every operation
+//   rwlock  - contains takes the read lock, insert and delete the write lock
+//   sharded - writes go unlocked to a per-thread shard and are logged; every
+//             CONTENTION_MERGE_INTERVAL operations the log is replayed into
+//             the shared structure under the write lock. Reads check the
+//             thread's own shard, then the shared structure under the read
+//             lock, so other threads' writes show up after their next merge.
+// Each line reports aggregate throughput plus per-thread latency percentiles
+// (averaged over threads) and the worst thread's p99.
+
+#define CONTENTION_MAX_THREADS 8
+#define CONTENTION_OPS_PER_THREAD 20000
+#define CONTENTION_KEY_RANGE 1024
+#define CONTENTION_READ_PERCENT 80
+#define CONTENTION_MERGE_INTERVAL 256
+
+typedef enum ContentionStrategy {
+    STRATEGY_MUTEX,
+    STRATEGY_RWLOCK,
+    STRATEGY_SHARDED
+} ContentionStrategy;
+
+typedef enum ContentionOp {
+    OP_CONTAINS,
+    OP_INSERT,
+    OP_DELETE
+} ContentionOp;
+
+typedef struct ContentionTarget {
+    const char* name;
+    size_t size;
+    void (*init)(void*);
+    void (*insert)(void*, int);
+    void (*delete)(void*, int);
+    int (*contains)(void*, int);
+    void (*clear)(void*);
+} ContentionTarget;
+
+typedef struct ContentionShared {
+    const ContentionTarget* target;
+    ContentionStrategy strategy;
+    void* list;
+    pthread_mutex_t mutex;
+    pthread_rwlock_t rwlock;
+    pthread_barrier_t start;
+} ContentionShared;
+
+typedef struct ContentionTask {
+    ContentionShared* shared;
+    int cpu;
+    unsigned int seed;
+    long* latencies;
+    double start;
+    double end;
+} ContentionTask;
+
+void initContentionArrayList(ArrayList* list) {
+    initArrayList(list, 1000);
+}
+
+void initContentionArrayRing(ArrayRing* ring) {
+    initArrayRing(ring, 1000);
+}
+
+void initContentionArrayBlock(ArrayBlock* block) {
+    initArrayBlock(block, 1000, 1000);
+}
+
+#define CONTENTION_TARGET(type, initFn) \
+    { #type, sizeof(type), (void (*)(void*))initFn, (void (*)(void*, int))insert##type, \
+      (void (*)(void*, int))delete##type, (int (*)(void*, int))contains##type, (void (*)(void*))clear##type }
+
+const ContentionTarget contentionTargets[] = {
+    CONTENTION_TARGET(NoCacheList, initNoCacheList),
+    CONTENTION_TARGET(LinkedList, initLinkedList),
+    CONTENTION_TARGET(SingleList, initSingleList),
+    CONTENTION_TARGET(ArrayList, initContentionArrayList),
+    CONTENTION_TARGET(ArrayRing, initContentionArrayRing),
+    CONTENTION_TARGET(ArrayBlock, initContentionArrayBlock),
+};
+
+const char* contentionStrategyNames[] = { "mutex", "rwlock", "sharded" };
+
+void applyContentionOp(const ContentionTarget* target, void* list, ContentionOp op, int key) {
+    if (op == OP_INSERT) {
+        target->insert(list, key);
+    } else {
+        target->delete(list, key);
+    }
+}
+
+void mergeContentionShard(ContentionShared* shared, void* shard, int* log, int* logged) {
+    const ContentionTarget* target = shared->target;
+    pthread_rwlock_wrlock(&shared->rwlock);
+    for (int i = 0; i < *logged; i++) {
+        applyContentionOp(target, shared->list, (ContentionOp)(log[i] & 3), log[i] >> 2);
+    }
+    pthread_rwlock_unlock(&shared->rwlock);
+    target->clear(shard);
+    target->init(shard);
+    *logged = 0;
+}
+
+void runContentionOp(ContentionShared* shared, void* shard, int* log, int* logged, ContentionOp op, int key) {
+    const ContentionTarget* target = shared->target;
+    switch (shared->strategy) {
+        case STRATEGY_MUTEX:
+            pthread_mutex_lock(&shared->mutex);
+            if (op == OP_CONTAINS) {
+                target->contains(shared->list, key);
+            } else {
+                applyContentionOp(target, shared->list, op, key);
+            }
+            pthread_mutex_unlock(&shared->mutex);
+            break;
+        case STRATEGY_RWLOCK:
+            if (op == OP_CONTAINS) {
+                pthread_rwlock_rdlock(&shared->rwlock);
+                target->contains(shared->list, key);
+            } else {
+                pthread_rwlock_wrlock(&shared->rwlock);
+                applyContentionOp(target, shared->list, op, key);
+            }
+            pthread_rwlock_unlock(&shared->rwlock);
+            break;
+        case STRATEGY_SHARDED:
+            if (op == OP_CONTAINS) {
+                if (!target->contains(shard, key)) {
+                    pthread_rwlock_rdlock(&shared->rwlock);
+                    target->contains(shared->list, key);
+                    pthread_rwlock_unlock(&shared->rwlock);
+                }
+            } else {
+                applyContentionOp(target, shard, op, key);
+                log[(*logged)++] = key << 2 | op;
+                if (*logged == CONTENTION_MERGE_INTERVAL) {
+                    mergeContentionShard(shared, shard, log, logged);
+                }
+            }
+            break;
+    }
+}
+
+void* contentionWorker(void* arg) {
+    ContentionTask* task = (ContentionTask*)arg;
+    ContentionShared* shared = task->shared;
+    const ContentionTarget* target = shared->target;
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(task->cpu, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+
+    void* shard = NULL;
+    int* log = NULL;
+    int logged = 0;
+    if (shared->strategy == STRATEGY_SHARDED) {
+        shard = malloc(target->size);
+        log = (int*)malloc(CONTENTION_MERGE_INTERVAL * sizeof(int));
+        target->init(shard);
+    }
+
+    unsigned int state = task->seed;
+    pthread_barrier_wait(&shared->start);
+    task->start = wallSeconds();
+    for (int i = 0; i < CONTENTION_OPS_PER_THREAD; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        int key = (int)((state >> 8) % CONTENTION_KEY_RANGE);
+        int roll = (int)(state % 100);
+        ContentionOp op = roll < CONTENTION_READ_PERCENT ? OP_CONTAINS : (roll & 1) ? OP_INSERT : OP_DELETE;
+
+        struct timespec before, after;
+        clock_gettime(CLOCK_MONOTONIC, &before);
+        runContentionOp(shared, shard, log, &logged, op, key);
+        clock_gettime(CLOCK_MONOTONIC, &after);
+        task->latencies[i] = (after.tv_sec - before.tv_sec) * 1000000000L + (after.tv_nsec - before.tv_nsec);
+    }
+    if (shard != NULL) {
+        mergeContentionShard(shared, shard, log, &logged);
+        target->clear(shard);
+        free(shard);
+        free(log);
+    }
+    task->end = wallSeconds();
+    return NULL;
+}
+
+int compareLatency(const void* a, const void* b) {
+    long x = *(const long*)a;
+    long y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+void contentionRun(const ContentionTarget* target, ContentionStrategy strategy, int numThreads, int numCpus) {
+    ContentionShared shared;
+    shared.target = target;
+    shared.strategy = strategy;
+    shared.list = malloc(target->size);
+    target->init(shared.list);
+    for (int key = 0; key < CONTENTION_KEY_RANGE; key += 2) {
+        target->insert(shared.list, key);
+    }
+    pthread_mutex_init(&shared.mutex, NULL);
+    pthread_rwlock_init(&shared.rwlock, NULL);
+    pthread_barrier_init(&shared.start, NULL, numThreads);
+
+    pthread_t threads[CONTENTION_MAX_THREADS];
+    ContentionTask tasks[CONTENTION_MAX_THREADS];
+    for (int t = 0; t < numThreads; t++) {
+        tasks[t].shared = &shared;
+        tasks[t].cpu = t % numCpus;
+        tasks[t].seed = 2463534242u + 7919u * t;
+        tasks[t].latencies = (long*)malloc(CONTENTION_OPS_PER_THREAD * sizeof(long));
+        pthread_create(&threads[t], NULL, contentionWorker, &tasks[t]);
+    }
+    for (int t = 0; t < numThreads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    double first = tasks[0].start, last = tasks[0].end;
+    double p50 = 0, p99 = 0, p999 = 0;
+    long worstP99 = 0;
+    for (int t = 0; t < numThreads; t++) {
+        long* latencies = tasks[t].latencies;
+        qsort(latencies, CONTENTION_OPS_PER_THREAD, sizeof(long), compareLatency);
+        p50 += latencies[CONTENTION_OPS_PER_THREAD / 2];
+        p99 += latencies[CONTENTION_OPS_PER_THREAD * 99 / 100];
+        p999 += latencies[CONTENTION_OPS_PER_THREAD * 999 / 1000];
+        if (latencies[CONTENTION_OPS_PER_THREAD * 99 / 100] > worstP99) {
+            worstP99 = latencies[CONTENTION_OPS_PER_THREAD * 99 / 100];
+        }
+        first = tasks[t].start < first ? tasks[t].start : first;
+        last = tasks[t].end > last ? tasks[t].end : last;
+        free(latencies);
+    }
+    printf("%-12s %-8s T=%d: %10.3f Mops/s, p50 %6.0f ns, p99 %8.0f ns, p99.9 %8.0f ns, worst-thread p99 %8ld ns\n",
+           target->name, contentionStrategyNames[strategy], numThreads,
+           (double)CONTENTION_OPS_PER_THREAD * numThreads / (last - first) / 1e6,
+           p50 / numThreads, p99 / numThreads, p999 / numThreads, worstP99);
+
+    pthread_barrier_destroy(&shared.start);
+    pthread_rwlock_destroy(&shared.rwlock);
+    pthread_mutex_destroy(&shared.mutex);
+    target->clear(shared.list);
+    free(shared.list);
+}
+
+void benchmarkContention(int maxThreads) {
+    int numCpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (maxThreads > CONTENTION_MAX_THREADS) {
+        maxThreads = CONTENTION_MAX_THREADS;
+    }
+    for (size_t i = 0; i < sizeof(contentionTargets) / sizeof(contentionTargets[0]); i++) {
+        for (int strategy = STRATEGY_MUTEX; strategy <= STRATEGY_SHARDED; strategy++) {
+            for (int threads = 1; threads <= maxThreads; threads *= 2) {
+                contentionRun(&contentionTargets[i], (ContentionStrategy)strategy, threads, numCpus);
+            }
+        }
+    }
+}
+
+
+int isOddValue(int value, void* arg) {
+    (void)arg;
+    return value & 1;
+}
+
+// Parallel count and removeIf over a large flat ArrayBlock, on the calling
+// thread against a pool with one worker per online CPU
+void benchmarkParallelScan() {
+    const int n = 10000000;
+    int numCpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    ThreadPool threadPool;
+    initThreadPool(&threadPool, numCpus > 1 ? numCpus : 1);
+    ThreadPool* pools[2] = { NULL, &threadPool };
+    for (int r = 0; r < 2; r++) {
+        ArrayBlock block;
+        initArrayBlock(&block, n, 1000);
+        for (int i = 0; i < n; i++) {
+            insertArrayBlock(&block, i);
+        }
+        double start = wallSeconds();
+        long found = countArrayBlockParallel(pools[r], &block, n / 2);
+        int removed = removeIfArrayBlockParallel(pools[r], &block, isOddValue, NULL);
+        printf("ArrayBlock count (%ld) and removeIf (%d) on %d threads: %f seconds\n", found, removed,
+               pools[r] ? pools[r]->numThreads : 1, wallSeconds() - start);
+        clearArrayBlock(&block);
+    }
+    destroyThreadPool(&threadPool);
+}
+
+
 int main() {
     printf("Running Bjarne Stroustrup's Benchmark:\n");
     benchmarkStroustrup();
@@ -435,5 +1995,17 @@ int main() {
     printf("\nRunning Fairbench:\n");
     benchmarkFairbench();
 
+    printf("\nRunning batched lookup benchmark:\n");
+    benchmarkBatchLookup();
+
+    printf("\nRunning parallel scan benchmark:\n");
+    benchmarkParallelScan();
+
+    printf("\nRunning ring queue throughput benchmark:\n");
+    benchmarkRingQueues();
+
+    printf("\nRunning contention benchmark:\n");
+    benchmarkContention(CONTENTION_MAX_THREADS);
+
     return 0;
 }
@@ -1,172 +1,2031 @@
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define SMALL_BUFFER_SIZE 16
+#define GROWTH_FACTOR 2
+#define BLOCK_SIZE 100
+
+// Singly Linked List Implementation
+
+typedef struct Node {
+    int data;
+    struct Node* next;
+} Node;
+
+void insert(Node** head, int value) {
+    Node* newNode = (Node*)malloc(sizeof(Node));
+    if (!newNode) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    newNode->data = value;
+    newNode->next = *head;
+    *head = newNode;
+}
+
+void delete(Node** head, int value) {
+    Node* temp = *head;
+    Node* prev = NULL;
+    while (temp != NULL && temp->data != value) {
+        prev = temp;
+        temp = temp->next;
+    }
+    if (temp == NULL) return;
+    if (prev == NULL) {
+        *head = temp->next;
+    } else {
+        prev->next = temp->next;
+    }
+    free(temp);
+}
+
+void printList(Node* head) {
+    Node* temp = head;
+    while (temp != NULL) {
+        printf("%d -> ", temp->data);
+        temp = temp->next;
+    }
+    printf("NULL\n");
+}
+
+// Radix Sort Implementation
+//
+// LSD radix sort over 8-bit digits. The sign bit is flipped so that negative
+// values order before positive ones. All four digit histograms are built in
+// a single read pass, and a pass is skipped when every key shares its digit,
+// so narrow value ranges cost fewer than four scatters.
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES ((int)(sizeof(int) * 8 / RADIX_BITS))
+#define SORT_UNIQUE 1
+
+// Sorts count ints ascending; scratch must hold count ints
+void radixSortInts(int* data, int* scratch, size_t count) {
+    size_t histogram[RADIX_PASSES][RADIX_BUCKETS];
+    memset(histogram, 0, sizeof(histogram));
+    for (size_t i = 0; i < count; i++) {
+        uint32_t key = (uint32_t)data[i] ^ 0x80000000u;
+        for (int pass = 0; pass < RADIX_PASSES; pass++) {
+            histogram[pass][(key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+        }
+    }
+
+    int* from = data;
+    int* to = scratch;
+    for (int pass = 0; count > 0 && pass < RADIX_PASSES; pass++) {
+        int shift = pass * RADIX_BITS;
+        size_t* bucket = histogram[pass];
+        if (bucket[(((uint32_t)from[0] ^ 0x80000000u) >> shift) & (RADIX_BUCKETS - 1)] == count) {
+            continue;
+        }
+        size_t offset = 0;
+        for (int b = 0; b < RADIX_BUCKETS; b++) {
+            size_t n = bucket[b];
+            bucket[b] = offset;
+            offset += n;
+        }
+        for (size_t i = 0; i < count; i++) {
+            uint32_t key = (uint32_t)from[i] ^ 0x80000000u;
+            to[bucket[(key >> shift) & (RADIX_BUCKETS - 1)]++] = from[i];
+        }
+        int* swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != data) {
+        memcpy(data, from, count * sizeof(int));
+    }
+}
+
+// Drops repeats from sorted data; returns the new count
+size_t uniqueSortedInts(int* data, size_t count) {
+    size_t kept = count > 0;
+    for (size_t i = 1; i < count; i++) {
+        if (data[i] != data[kept - 1]) {
+            data[kept++] = data[i];
+        }
+    }
+    return kept;
+}
+
+// Array-Based List Implementation
+
+// The first SMALL_BUFFER_SIZE elements live inline in the struct; the list
+// only spills to the heap once it outgrows them. While inline, data points
+// into the struct itself, so an ArrayList must not be copied by value.
+typedef struct ArrayList {
+    int* data;
+    int size;
+    int capacity;
+    int inlineData[SMALL_BUFFER_SIZE];
+} ArrayList;
+
+void initArrayList(ArrayList* list) {
+    list->data = list->inlineData;
+    list->size = 0;
+    list->capacity = SMALL_BUFFER_SIZE;
+}
+
+void insertArrayList(ArrayList* list, int value) {
+    if (list->size >= list->capacity) {
+        list->capacity *= GROWTH_FACTOR;
+        if (list->data == list->inlineData) {
+            list->data = (int*)malloc(list->capacity * sizeof(int));
+            if (list->data) {
+                memcpy(list->data, list->inlineData, list->size * sizeof(int));
+            }
+        } else {
+            list->data = (int*)realloc(list->data, list->capacity * sizeof(int));
+        }
+        if (!list->data) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+    }
+    list->data[list->size++] = value;
+}
+
+void deleteArrayList(ArrayList* list, int value) {
+    for (int i = 0; i < list->size; i++) {
+        if (list->data[i] == value) {
+            for (int j = i; j < list->size - 1; j++) {
+                list->data[j] = list->data[j + 1];
+            }
+            list->size--;
+            return;
+        }
+    }
+}
+
+void printArrayList(ArrayList* list) {
+    for (int i = 0; i < list->size; i++) {
+        printf("%d -> ", list->data[i]);
+    }
+    printf("NULL\n");
+}
+
+// Sorts ascending in place; with SORT_UNIQUE repeats are dropped as well
+void sortArrayList(ArrayList* list, int flags) {
+    if (list->size < 2) {
+        return;
+    }
+    int* scratch = (int*)malloc(list->size * sizeof(int));
+    if (!scratch) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    radixSortInts(list->data, scratch, list->size);
+    free(scratch);
+    if (flags & SORT_UNIQUE) {
+        list->size = (int)uniqueSortedInts(list->data, list->size);
+    }
+}
+
+void freeArrayList(ArrayList* list) {
+    if (list->data != list->inlineData) {
+        free(list->data);
+    }
+    list->data = list->inlineData;
+    list->size = 0;
+    list->capacity = SMALL_BUFFER_SIZE;
+}
+
+// Block Pool Implementation
+//
+// ArrayBlock storage is carved from cache-line-aligned arena chunks and
+// recycled through an intrusive free list, so steady-state inserts and
+// deletes never reach malloc/free. One pool can back any number of
+// ArrayBlocks. Pools are not thread-safe.
+
+#define CACHE_LINE_SIZE 64
+#define BLOCK_STRIDE (((BLOCK_SIZE * sizeof(int)) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE)
+#define POOL_CHUNK_BLOCKS 64
+
+typedef struct FreeBlock {
+    struct FreeBlock* next;
+} FreeBlock;
+
+typedef struct BlockPool {
+    char** chunks;
+    int numChunks;
+    int chunkCapacity;
+    char* arenaCursor;
+    int arenaRemaining;
+    FreeBlock* freeList;
+    int blocksInUse;
+    int blocksFree;
+    int highWaterMark;
+} BlockPool;
+
+typedef struct BlockPoolStats {
+    int blocksInUse;
+    int blocksFree;
+    int highWaterMark;
+} BlockPoolStats;
+
+// Shared by every ArrayBlock initialised without an explicit pool
+BlockPool defaultBlockPool;
+
+void initBlockPool(BlockPool* pool) {
+    pool->chunks = NULL;
+    pool->numChunks = 0;
+    pool->chunkCapacity = 0;
+    pool->arenaCursor = NULL;
+    pool->arenaRemaining = 0;
+    pool->freeList = NULL;
+    pool->blocksInUse = 0;
+    pool->blocksFree = 0;
+    pool->highWaterMark = 0;
+}
+
+int* acquireBlock(BlockPool* pool) {
+    int* result;
+    if (pool->freeList) {
+        result = (int*)pool->freeList;
+        pool->freeList = pool->freeList->next;
+    } else {
+        if (pool->arenaRemaining == 0) {
+            if (pool->numChunks == pool->chunkCapacity) {
+                pool->chunkCapacity = pool->chunkCapacity ? pool->chunkCapacity * GROWTH_FACTOR : 4;
+                pool->chunks = (char**)realloc(pool->chunks, pool->chunkCapacity * sizeof(char*));
+                if (!pool->chunks) {
+                    fprintf(stderr, "Memory allocation failed\n");
+                    exit(1);
+                }
+            }
+            char* chunk = (char*)aligned_alloc(CACHE_LINE_SIZE, BLOCK_STRIDE * POOL_CHUNK_BLOCKS);
+            if (!chunk) {
+                fprintf(stderr, "Memory allocation failed\n");
+                exit(1);
+            }
+            pool->chunks[pool->numChunks++] = chunk;
+            pool->arenaCursor = chunk;
+            pool->arenaRemaining = POOL_CHUNK_BLOCKS;
+            pool->blocksFree += POOL_CHUNK_BLOCKS;
+        }
+        result = (int*)pool->arenaCursor;
+        pool->arenaCursor += BLOCK_STRIDE;
+        pool->arenaRemaining--;
+    }
+    pool->blocksFree--;
+    pool->blocksInUse++;
+    if (pool->blocksInUse > pool->highWaterMark) {
+        pool->highWaterMark = pool->blocksInUse;
+    }
+    return result;
+}
+
+void releaseBlock(BlockPool* pool, int* data) {
+    FreeBlock* freed = (FreeBlock*)data;
+    freed->next = pool->freeList;
+    pool->freeList = freed;
+    pool->blocksInUse--;
+    pool->blocksFree++;
+}
+
+void getBlockPoolStats(BlockPool* pool, BlockPoolStats* stats) {
+    stats->blocksInUse = pool->blocksInUse;
+    stats->blocksFree = pool->blocksFree;
+    stats->highWaterMark = pool->highWaterMark;
+}
+
+// Frees every chunk; no ArrayBlock may still be using the pool
+void destroyBlockPool(BlockPool* pool) {
+    for (int i = 0; i < pool->numChunks; i++) {
+        free(pool->chunks[i]);
+    }
+    free(pool->chunks);
+    initBlockPool(pool);
+}
+
+// Sealed Block Implementation
+//
+// A full block can be sealed into a compact read-mostly form: its first value
+// plus the deltas between neighbours, frame-of-reference encoded as each
+// delta's distance from the smallest delta in bitWidth bits. Deltas use
+// wrapping 32-bit arithmetic, so any int sequence round-trips exactly. min
+// and max form a zone map that lets finds skip a block without decoding it.
+// A constant-stride run such as the sequential benchmark data packs to
+// bitWidth 0 and is searched in closed form. Blocks that would not shrink
+// are left unsealed.
+//
+// Offsets are unpacked eight at a time. Eight bitWidth-bit fields span
+// exactly bitWidth bytes, so every group starts on a byte boundary and each
+// lane's byte offset and shift within its group are constants of the width;
+// unpackSealedOffsets dispatches to a copy of the loop specialised for every
+// width. The running sum over the offsets then runs eight lanes at a time
+// with AVX2, four with SSE2, or one at a time otherwise.
+
+#define SEALED_DELTAS (BLOCK_SIZE - 1)
+#define SEALED_GROUPS ((SEALED_DELTAS + 7) / 8)
+
+typedef struct SealedBlock {
+    int first;
+    int minDelta;
+    int min;
+    int max;
+    int bitWidth;
+    uint32_t packed[];
+} SealedBlock;
+
+size_t sealedBlockBytes(int bitWidth) {
+    // Room for whole groups of eight plus two spare words, so decode can read
+    // every field of every group through an unaligned 64-bit window
+    return sizeof(SealedBlock) + ((SEALED_GROUPS * 8 * bitWidth + 31) / 32 + 2) * sizeof(uint32_t);
+}
+
+SealedBlock* encodeSealedBlock(const int* data) {
+    int32_t minDelta = INT32_MAX;
+    int min = data[0], max = data[0];
+    for (int i = 1; i < BLOCK_SIZE; i++) {
+        int32_t delta = (int32_t)((uint32_t)data[i] - (uint32_t)data[i - 1]);
+        minDelta = delta < minDelta ? delta : minDelta;
+        min = data[i] < min ? data[i] : min;
+        max = data[i] > max ? data[i] : max;
+    }
+    uint32_t maxOffset = 0;
+    for (int i = 1; i < BLOCK_SIZE; i++) {
+        uint32_t offset = (uint32_t)data[i] - (uint32_t)data[i - 1] - (uint32_t)minDelta;
+        maxOffset = offset > maxOffset ? offset : maxOffset;
+    }
+    int bitWidth = maxOffset ? 32 - __builtin_clz(maxOffset) : 0;
+    size_t bytes = sealedBlockBytes(bitWidth);
+    if (bytes >= BLOCK_SIZE * sizeof(int)) {
+        return NULL;
+    }
+
+    SealedBlock* sealed = (SealedBlock*)calloc(1, bytes);
+    if (!sealed) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    sealed->first = data[0];
+    sealed->minDelta = minDelta;
+    sealed->min = min;
+    sealed->max = max;
+    sealed->bitWidth = bitWidth;
+    for (int i = 0; bitWidth > 0 && i < SEALED_DELTAS; i++) {
+        uint32_t offset = (uint32_t)data[i + 1] - (uint32_t)data[i] - (uint32_t)minDelta;
+        int bitPos = i * bitWidth;
+        int shift = bitPos & 31;
+        sealed->packed[bitPos >> 5] |= offset << shift;
+        if (shift + bitWidth > 32) {
+            sealed->packed[(bitPos >> 5) + 1] |= offset >> (32 - shift);
+        }
+    }
+    return sealed;
+}
+
+static inline __attribute__((always_inline)) uint64_t loadSealedWindow(const uint8_t* bytes) {
+    uint64_t window;
+    memcpy(&window, bytes, sizeof(window));
+    return window;
+}
+
+#define UNPACK_SEALED_LANE(k) \
+    offsets[g * 8 + (k)] = (uint32_t)((loadSealedWindow(base + ((k) * bitWidth >> 3)) >> (((k) * bitWidth) & 7)) & mask)
+
+static inline __attribute__((always_inline)) void unpackSealedGroups(const uint8_t* bytes, uint32_t* offsets, const int bitWidth) {
+    const uint64_t mask = (1ULL << bitWidth) - 1;
+    for (int g = 0; g < SEALED_GROUPS; g++) {
+        const uint8_t* base = bytes + g * bitWidth;
+        UNPACK_SEALED_LANE(0);
+        UNPACK_SEALED_LANE(1);
+        UNPACK_SEALED_LANE(2);
+        UNPACK_SEALED_LANE(3);
+        UNPACK_SEALED_LANE(4);
+        UNPACK_SEALED_LANE(5);
+        UNPACK_SEALED_LANE(6);
+        UNPACK_SEALED_LANE(7);
+    }
+}
+
+#define UNPACK_SEALED_WIDTH(w) case w: unpackSealedGroups(bytes, offsets, w); break;
+
+// Fills offsets[0 .. SEALED_GROUPS * 8); entries past SEALED_DELTAS are padding
+void unpackSealedOffsets(const SealedBlock* sealed, uint32_t* offsets) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    const uint8_t* bytes = (const uint8_t*)sealed->packed;
+    switch (sealed->bitWidth) {
+        UNPACK_SEALED_WIDTH(1) UNPACK_SEALED_WIDTH(2) UNPACK_SEALED_WIDTH(3) UNPACK_SEALED_WIDTH(4)
+        UNPACK_SEALED_WIDTH(5) UNPACK_SEALED_WIDTH(6) UNPACK_SEALED_WIDTH(7) UNPACK_SEALED_WIDTH(8)
+        UNPACK_SEALED_WIDTH(9) UNPACK_SEALED_WIDTH(10) UNPACK_SEALED_WIDTH(11) UNPACK_SEALED_WIDTH(12)
+        UNPACK_SEALED_WIDTH(13) UNPACK_SEALED_WIDTH(14) UNPACK_SEALED_WIDTH(15) UNPACK_SEALED_WIDTH(16)
+        UNPACK_SEALED_WIDTH(17) UNPACK_SEALED_WIDTH(18) UNPACK_SEALED_WIDTH(19) UNPACK_SEALED_WIDTH(20)
+        UNPACK_SEALED_WIDTH(21) UNPACK_SEALED_WIDTH(22) UNPACK_SEALED_WIDTH(23) UNPACK_SEALED_WIDTH(24)
+        UNPACK_SEALED_WIDTH(25) UNPACK_SEALED_WIDTH(26) UNPACK_SEALED_WIDTH(27) UNPACK_SEALED_WIDTH(28)
+        UNPACK_SEALED_WIDTH(29) UNPACK_SEALED_WIDTH(30) UNPACK_SEALED_WIDTH(31) UNPACK_SEALED_WIDTH(32)
+    }
+#else
+    // The byte-window unpack assumes little-endian words
+    int bitWidth = sealed->bitWidth;
+    uint64_t mask = (1ULL << bitWidth) - 1;
+    for (int i = 0; i < SEALED_GROUPS * 8; i++) {
+        int bitPos = i * bitWidth;
+        uint64_t window = sealed->packed[bitPos >> 5] | (uint64_t)sealed->packed[(bitPos >> 5) + 1] << 32;
+        offsets[i] = (uint32_t)((window >> (bitPos & 31)) & mask);
+    }
+#endif
+}
+
+// out[0] = first and out[i + 1] = out[i] + offsets[i] + minDelta, with
+// wrapping arithmetic
+void sumSealedOffsets(const uint32_t* offsets, uint32_t first, uint32_t minDelta, int* out) {
+    int i = 0;
+    out[0] = (int)first;
+#if defined(__AVX2__)
+    __m256i delta = _mm256_set1_epi32((int)minDelta);
+    __m256i carry = _mm256_set1_epi32((int)first);
+    __m256i lastLane = _mm256_set1_epi32(7);
+    for (; i + 8 <= SEALED_DELTAS; i += 8) {
+        __m256i x = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(offsets + i)), delta);
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+        // Carry the low half's total into the high half
+        __m256i low = _mm256_shuffle_epi32(x, 0xff);
+        x = _mm256_add_epi32(x, _mm256_permute2x128_si256(low, low, 0x08));
+        x = _mm256_add_epi32(x, carry);
+        _mm256_storeu_si256((__m256i*)(out + i + 1), x);
+        carry = _mm256_permutevar8x32_epi32(x, lastLane);
+    }
+    first = (uint32_t)out[i];
+#elif defined(__SSE2__)
+    __m128i delta = _mm_set1_epi32((int)minDelta);
+    __m128i carry = _mm_set1_epi32((int)first);
+    for (; i + 4 <= SEALED_DELTAS; i += 4) {
+        __m128i x = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(offsets + i)), delta);
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, carry);
+        _mm_storeu_si128((__m128i*)(out + i + 1), x);
+        carry = _mm_shuffle_epi32(x, 0xff);
+    }
+    first = (uint32_t)out[i];
+#endif
+    for (; i < SEALED_DELTAS; i++) {
+        first += offsets[i] + minDelta;
+        out[i + 1] = (int)first;
+    }
+}
+
+void decodeSealedBlock(const SealedBlock* sealed, int* out) {
+    uint32_t first = (uint32_t)sealed->first;
+    uint32_t minDelta = (uint32_t)sealed->minDelta;
+    if (sealed->bitWidth == 0) {
+        for (int i = 0; i < BLOCK_SIZE; i++) {
+            out[i] = (int)(first + (uint32_t)i * minDelta);
+        }
+        return;
+    }
+    uint32_t offsets[SEALED_GROUPS * 8];
+    unpackSealedOffsets(sealed, offsets);
+    sumSealedOffsets(offsets, first, minDelta, out);
+}
+
+// Constant-stride blocks that do not wrap around the int range can be
+// searched without decoding
+int isArithmeticSealedBlock(const SealedBlock* sealed) {
+    long long last = (long long)sealed->first + (long long)SEALED_DELTAS * sealed->minDelta;
+    return sealed->bitWidth == 0 && last >= INT32_MIN && last <= INT32_MAX;
+}
+
+int findInSealedBlock(const SealedBlock* sealed, int value, int* scratch) {
+    if (value < sealed->min || value > sealed->max) {
+        return -1;
+    }
+    if (isArithmeticSealedBlock(sealed)) {
+        if (sealed->minDelta == 0) {
+            return 0;
+        }
+        long long distance = (long long)value - sealed->first;
+        return distance % sealed->minDelta == 0 ? (int)(distance / sealed->minDelta) : -1;
+    }
+    decodeSealedBlock(sealed, scratch);
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        if (scratch[i] == value) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int countInSealedBlock(const SealedBlock* sealed, int value, int* scratch) {
+    if (value < sealed->min || value > sealed->max) {
+        return 0;
+    }
+    if (isArithmeticSealedBlock(sealed)) {
+        if (sealed->minDelta == 0) {
+            return BLOCK_SIZE;
+        }
+        return ((long long)value - sealed->first) % sealed->minDelta == 0;
+    }
+    decodeSealedBlock(sealed, scratch);
+    int count = 0;
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        count += scratch[i] == value;
+    }
+    return count;
+}
+
+// Snapshot Format
+//
+// Same file format as the snapshots in Prototype_Instruct.c: one header page,
+// then the elements from the page-aligned dataOffset, zero padded to a whole
+// page. A segmented ArrayBlock is stored as whole BLOCK_SIZE blocks (the last
+// one zero filled), so a loaded ArrayBlock points its block directory straight
+// into the mapping. SNAPSHOT_READ_ONLY maps read-only pages and a block is
+// copied into the pool the first time it is mutated; SNAPSHOT_COPY_ON_WRITE
+// maps private writable pages, so edits never reach the file. The header
+// checksum is always checked; SNAPSHOT_VERIFY also checks the data checksum.
+// save and load return 0 on success and -1 on an I/O error or a missing,
+// foreign or corrupt file.
+
+#define SNAPSHOT_MAGIC 0x4b434f4c42595241ULL
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_PAGE_SIZE 4096
+
+#define SNAPSHOT_READ_ONLY 0
+#define SNAPSHOT_COPY_ON_WRITE 1
+#define SNAPSHOT_VERIFY 2
+
+enum SnapshotKind {
+    SNAPSHOT_ARRAY_LIST = 1,
+    SNAPSHOT_ARRAY_BLOCK = 2,
+    SNAPSHOT_SEGMENTED_ARRAY_BLOCK = 3
+};
+
+typedef struct SnapshotHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t kind;
+    uint64_t count;
+    uint32_t blockSize;
+    uint32_t reserved;
+    uint64_t dataOffset;
+    uint64_t dataBytes;
+    uint64_t dataChecksum;
+    uint64_t headerChecksum;
+} SnapshotHeader;
+
+typedef struct SnapshotMapping {
+    void* address;
+    size_t bytes;
+    int writable;
+} SnapshotMapping;
+
+// FNV-1a over 32-bit words, so it can be fed block by block
+uint64_t updateSnapshotChecksum(uint64_t hash, const void* data, size_t bytes) {
+    const uint32_t* words = (const uint32_t*)data;
+    for (size_t i = 0; i < bytes / sizeof(uint32_t); i++) {
+        hash ^= words[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+uint64_t snapshotChecksum(const void* data, size_t bytes) {
+    return updateSnapshotChecksum(0xcbf29ce484222325ULL, data, bytes);
+}
+
+void initSnapshotHeader(SnapshotHeader* header, uint32_t kind, uint64_t count, uint32_t blockSize, uint64_t dataBytes) {
+    memset(header, 0, sizeof(*header));
+    header->magic = SNAPSHOT_MAGIC;
+    header->version = SNAPSHOT_VERSION;
+    header->kind = kind;
+    header->count = count;
+    header->blockSize = blockSize;
+    header->dataOffset = SNAPSHOT_PAGE_SIZE;
+    header->dataBytes = dataBytes;
+}
+
+int mapSnapshot(const char* path, uint32_t kind, int flags, SnapshotMapping* mapping, SnapshotHeader* header) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < SNAPSHOT_PAGE_SIZE) {
+        close(fd);
+        return -1;
+    }
+    int writable = flags & SNAPSHOT_COPY_ON_WRITE;
+    void* address = mmap(NULL, info.st_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        return -1;
+    }
+
+    memcpy(header, address, sizeof(*header));
+    int valid = header->magic == SNAPSHOT_MAGIC && header->version == SNAPSHOT_VERSION && header->kind == kind &&
+                header->headerChecksum == snapshotChecksum(header, offsetof(SnapshotHeader, headerChecksum)) &&
+                header->dataOffset % SNAPSHOT_PAGE_SIZE == 0 &&
+                header->dataOffset + header->dataBytes <= (uint64_t)info.st_size &&
+                header->count <= header->dataBytes / sizeof(int) && header->count <= INT32_MAX;
+    if (valid && (flags & SNAPSHOT_VERIFY)) {
+        valid = snapshotChecksum((char*)address + header->dataOffset, header->dataBytes) == header->dataChecksum;
+    }
+    if (!valid) {
+        munmap(address, info.st_size);
+        return -1;
+    }
+    mapping->address = address;
+    mapping->bytes = info.st_size;
+    mapping->writable = writable;
+    return 0;
+}
+
+void initSnapshotMapping(SnapshotMapping* mapping) {
+    mapping->address = NULL;
+    mapping->bytes = 0;
+    mapping->writable = 0;
+}
+
+void unmapSnapshot(SnapshotMapping* mapping) {
+    if (mapping->address != NULL) {
+        munmap(mapping->address, mapping->bytes);
+    }
+    initSnapshotMapping(mapping);
+}
+
+// Block File Implementation
+//
+// Out-of-core storage for ArrayBlock. Block i lives at offset
+// i * BLOCK_FILE_BYTES of a local file and only a bounded cache of frames is
+// held in memory. Frames are evicted with the CLOCK algorithm; dirty frames
+// are written back on eviction and on flush. When blocks are missed in
+// ascending order, a window of BLOCK_FILE_READAHEAD_BYTES past the miss is
+// handed to the kernel with posix_fadvise(WILLNEED), which reads it in
+// asynchronously while the current blocks are scanned. The advice is issued
+// once per window: only when the scan passes the middle of the advised range
+// is the next stretch requested. A frame pointer stays valid only until the
+// next access to the same file. Cached blocks are found through a hash table
+// of frame chains sized to the cache, so the memory a block file holds does
+// not grow with the number of blocks in it. Block files are not thread-safe.
+
+#define BLOCK_FILE_BYTES (BLOCK_SIZE * sizeof(int))
+#define BLOCK_FILE_READAHEAD_BYTES (1 << 20)
+#define BLOCK_FILE_READAHEAD ((int)(BLOCK_FILE_READAHEAD_BYTES / BLOCK_FILE_BYTES))
+#define BLOCK_FILE_MIN_FRAMES 2
+
+typedef struct BlockFrame {
+    int* data;
+    int blockIndex;
+    int referenced;
+    int dirty;
+    int next;
+} BlockFrame;
+
+typedef struct BlockFile {
+    int fd;
+    BlockFrame* frames;
+    int numFrames;
+    int clockHand;
+    int* buckets;
+    int bucketMask;
+    int lastBlock;
+    int readaheadStart;
+    int readaheadEnd;
+} BlockFile;
+
+// Creates (or truncates) path; returns NULL if it cannot be opened
+BlockFile* openBlockFile(const char* path, int cacheBlocks) {
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+    BlockFile* file = (BlockFile*)malloc(sizeof(BlockFile));
+    int numFrames = cacheBlocks > BLOCK_FILE_MIN_FRAMES ? cacheBlocks : BLOCK_FILE_MIN_FRAMES;
+    if (!file || !(file->frames = (BlockFrame*)malloc(numFrames * sizeof(BlockFrame)))) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < numFrames; i++) {
+        file->frames[i].data = (int*)aligned_alloc(CACHE_LINE_SIZE, BLOCK_STRIDE);
+        if (!file->frames[i].data) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+        file->frames[i].blockIndex = -1;
+        file->frames[i].referenced = 0;
+        file->frames[i].dirty = 0;
+        file->frames[i].next = -1;
+    }
+    int numBuckets = 1;
+    while (numBuckets < numFrames) {
+        numBuckets *= 2;
+    }
+    file->buckets = (int*)malloc(numBuckets * sizeof(int));
+    if (!file->buckets) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < numBuckets; i++) {
+        file->buckets[i] = -1;
+    }
+    file->fd = fd;
+    file->numFrames = numFrames;
+    file->clockHand = 0;
+    file->bucketMask = numBuckets - 1;
+    file->lastBlock = -1;
+    file->readaheadStart = 0;
+    file->readaheadEnd = 0;
+    return file;
+}
+
+void writeBackBlockFrame(BlockFile* file, BlockFrame* frame) {
+    if (frame->dirty) {
+        if (pwrite(file->fd, frame->data, BLOCK_FILE_BYTES, (off_t)frame->blockIndex * BLOCK_FILE_BYTES) != (ssize_t)BLOCK_FILE_BYTES) {
+            fprintf(stderr, "Block file write failed\n");
+            exit(1);
+        }
+        frame->dirty = 0;
+    }
+}
+
+void readBlockFrame(BlockFile* file, BlockFrame* frame, int index) {
+    size_t done = 0;
+    while (done < BLOCK_FILE_BYTES) {
+        ssize_t n = pread(file->fd, (char*)frame->data + done, BLOCK_FILE_BYTES - done,
+                          (off_t)index * BLOCK_FILE_BYTES + done);
+        if (n < 0) {
+            fprintf(stderr, "Block file read failed\n");
+            exit(1);
+        }
+        if (n == 0) {
+            // Past the end of the file: the block has never been written
+            memset((char*)frame->data + done, 0, BLOCK_FILE_BYTES - done);
+            break;
+        }
+        done += n;
+    }
+}
+
+// Extends the advised range to a full window past next, unless next is still
+// in the first half of the range already advised
+void adviseBlockFileReadahead(BlockFile* file, int next) {
+    int inWindow = next >= file->readaheadStart && next < file->readaheadEnd;
+    if (inWindow && next < file->readaheadEnd - BLOCK_FILE_READAHEAD / 2) {
+        return;
+    }
+    int from = inWindow ? file->readaheadEnd : next;
+    int end = next + BLOCK_FILE_READAHEAD;
+    posix_fadvise(file->fd, (off_t)from * BLOCK_FILE_BYTES, (off_t)(end - from) * BLOCK_FILE_BYTES,
+                  POSIX_FADV_WILLNEED);
+    file->readaheadStart = next;
+    file->readaheadEnd = end;
+}
+
+// Frame caching block index, or -1
+int findBlockFrame(BlockFile* file, int index) {
+    int f = file->buckets[index & file->bucketMask];
+    while (f >= 0 && file->frames[f].blockIndex != index) {
+        f = file->frames[f].next;
+    }
+    return f;
+}
+
+void linkBlockFrame(BlockFile* file, int f) {
+    int* bucket = &file->buckets[file->frames[f].blockIndex & file->bucketMask];
+    file->frames[f].next = *bucket;
+    *bucket = f;
+}
+
+void unlinkBlockFrame(BlockFile* file, int f) {
+    int* link = &file->buckets[file->frames[f].blockIndex & file->bucketMask];
+    while (*link != f) {
+        link = &file->frames[*link].next;
+    }
+    *link = file->frames[f].next;
+    file->frames[f].next = -1;
+}
+
+// Frame holding block index, loading it (and evicting another) if needed
+int* accessBlockFile(BlockFile* file, int index, int dirty) {
+    BlockFrame* frame;
+    int cached = findBlockFrame(file, index);
+    if (cached >= 0) {
+        frame = &file->frames[cached];
+    } else {
+        while (file->frames[file->clockHand].referenced) {
+            file->frames[file->clockHand].referenced = 0;
+            file->clockHand = (file->clockHand + 1) % file->numFrames;
+        }
+        frame = &file->frames[file->clockHand];
+        if (frame->blockIndex >= 0) {
+            writeBackBlockFrame(file, frame);
+            unlinkBlockFrame(file, file->clockHand);
+        }
+        if (index == file->lastBlock + 1) {
+            adviseBlockFileReadahead(file, index + 1);
+        }
+        readBlockFrame(file, frame, index);
+        frame->blockIndex = index;
+        linkBlockFrame(file, file->clockHand);
+        file->clockHand = (file->clockHand + 1) % file->numFrames;
+    }
+    file->lastBlock = index;
+    frame->referenced = 1;
+    frame->dirty |= dirty;
+    return frame->data;
+}
+
+// Forgets a cached block without writing it back
+void discardBlockFileBlock(BlockFile* file, int index) {
+    int f = findBlockFrame(file, index);
+    if (f >= 0) {
+        unlinkBlockFrame(file, f);
+        file->frames[f].blockIndex = -1;
+        file->frames[f].referenced = 0;
+        file->frames[f].dirty = 0;
+    }
+}
+
+void flushBlockFile(BlockFile* file) {
+    for (int i = 0; i < file->numFrames; i++) {
+        if (file->frames[i].blockIndex >= 0) {
+            writeBackBlockFrame(file, &file->frames[i]);
+        }
+    }
+}
+
+// Drops every block from index numBlocks on, both cached and on disk
+void truncateBlockFile(BlockFile* file, int numBlocks) {
+    for (int i = 0; i < file->numFrames; i++) {
+        if (file->frames[i].blockIndex >= numBlocks) {
+            discardBlockFileBlock(file, file->frames[i].blockIndex);
+        }
+    }
+    if (ftruncate(file->fd, (off_t)numBlocks * BLOCK_FILE_BYTES) != 0) {
+        fprintf(stderr, "Block file truncate failed\n");
+        exit(1);
+    }
+}
+
+void closeBlockFile(BlockFile* file) {
+    flushBlockFile(file);
+    close(file->fd);
+    for (int i = 0; i < file->numFrames; i++) {
+        free(file->frames[i].data);
+    }
+    free(file->frames);
+    free(file->buckets);
+    free(file);
+}
+
+// ArrayBlock Implementation
+//
+// Blocks 0..currentBlockIndex are allocated; every block except the last is
+// full, and the last holds currentBlockSize elements. numBlocks is the
+// capacity of the block directory. A block is either plain (blocks[i]) or,
+// once full and if sealing is enabled, sealed (sealed[i], blocks[i] NULL).
+// A delete leaves the full blocks it shifts plain and records the first of
+// them in resealFrom (-1 when none); they are resealed together by
+// resealArrayBlock, which runs when insert moves on to a new block, after
+// RESEAL_DELETE_BURST deletes, or when the caller ends a burst of deletes.
+// Blocks of a loaded snapshot point into its mapping. A file-backed ArrayBlock
+// has no block directory at all (blocks and sealed are NULL): its blocks live
+// in a BlockFile, so its memory is bounded by the block cache. Code outside
+// this section reaches block contents only through readBlock and
+// writableBlock; a mutation unseals the block it touches and copies a
+// read-only mapped block. In file-backed mode a returned pointer is valid
+// only until the next block access.
+
+#define RESEAL_DELETE_BURST 32
+
+typedef struct ArrayBlock {
+    int** blocks;
+    SealedBlock** sealed;
+    int numBlocks;
+    int currentBlockIndex;
+    int currentBlockSize;
+    int sealFullBlocks;
+    int resealFrom;
+    int deletesSinceReseal;
+    BlockPool* pool;
+    SnapshotMapping snapshot;
+    BlockFile* file;
+} ArrayBlock;
+
+void initArrayBlockWithPool(ArrayBlock* block, BlockPool* pool) {
+    block->blocks = (int**)malloc(sizeof(int*));
+    block->sealed = (SealedBlock**)malloc(sizeof(SealedBlock*));
+    if (!block->blocks || !block->sealed) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    block->pool = pool;
+    block->blocks[0] = acquireBlock(pool);
+    block->sealed[0] = NULL;
+    block->numBlocks = 1;
+    block->currentBlockIndex = 0;
+    block->currentBlockSize = 0;
+    block->sealFullBlocks = 0;
+    block->resealFrom = -1;
+    block->deletesSinceReseal = 0;
+    initSnapshotMapping(&block->snapshot);
+    block->file = NULL;
+}
+
+void initArrayBlock(ArrayBlock* block) {
+    initArrayBlockWithPool(block, &defaultBlockPool);
+}
+
+// Same API, but blocks live in the file at path (created or truncated) and at
+// most cacheBlocks of them are held in memory. Returns -1 if the file cannot
+// be opened. Sealing is not applied to file-backed blocks.
+int initArrayBlockFileBacked(ArrayBlock* block, const char* path, int cacheBlocks) {
+    BlockFile* file = openBlockFile(path, cacheBlocks);
+    if (file == NULL) {
+        return -1;
+    }
+    block->blocks = NULL;
+    block->sealed = NULL;
+    block->pool = &defaultBlockPool;
+    block->numBlocks = 0;
+    block->currentBlockIndex = 0;
+    block->currentBlockSize = 0;
+    block->sealFullBlocks = 0;
+    block->resealFrom = -1;
+    block->deletesSinceReseal = 0;
+    initSnapshotMapping(&block->snapshot);
+    block->file = file;
+    return 0;
+}
+
+int blockLength(ArrayBlock* block, int index) {
+    return index < block->currentBlockIndex ? BLOCK_SIZE : block->currentBlockSize;
+}
+
+int sizeArrayBlock(ArrayBlock* block) {
+    return block->currentBlockIndex * BLOCK_SIZE + block->currentBlockSize;
+}
+
+// Contents of block index; sealed blocks are decoded into scratch
+const int* readBlock(ArrayBlock* block, int index, int* scratch) {
+    if (block->file) {
+        return accessBlockFile(block->file, index, 0);
+    }
+    if (block->sealed[index]) {
+        decodeSealedBlock(block->sealed[index], scratch);
+        return scratch;
+    }
+    return block->blocks[index];
+}
+
+int blockFirst(ArrayBlock* block, int index) {
+    if (block->file) {
+        return accessBlockFile(block->file, index, 0)[0];
+    }
+    return block->sealed[index] ? block->sealed[index]->first : block->blocks[index][0];
+}
+
+int isMappedBlock(ArrayBlock* block, const int* data) {
+    char* address = (char*)block->snapshot.address;
+    return address != NULL && (const char*)data >= address && (const char*)data < address + block->snapshot.bytes;
+}
+
+// Pool blocks go back to the pool; mapped blocks are owned by the mapping
+void releasePlainBlock(ArrayBlock* block, int* data) {
+    if (!isMappedBlock(block, data)) {
+        releaseBlock(block->pool, data);
+    }
+}
+
+int* writableBlock(ArrayBlock* block, int index) {
+    if (block->file) {
+        return accessBlockFile(block->file, index, 1);
+    }
+    if (block->sealed[index]) {
+        block->blocks[index] = acquireBlock(block->pool);
+        decodeSealedBlock(block->sealed[index], block->blocks[index]);
+        free(block->sealed[index]);
+        block->sealed[index] = NULL;
+    } else if (!block->snapshot.writable && isMappedBlock(block, block->blocks[index])) {
+        int* data = acquireBlock(block->pool);
+        memcpy(data, block->blocks[index], BLOCK_SIZE * sizeof(int));
+        block->blocks[index] = data;
+    }
+    return block->blocks[index];
+}
+
+void sealBlock(ArrayBlock* block, int index) {
+    if (block->file || block->sealed[index] || blockLength(block, index) < BLOCK_SIZE) {
+        return;
+    }
+    SealedBlock* sealed = encodeSealedBlock(block->blocks[index]);
+    if (sealed) {
+        releasePlainBlock(block, block->blocks[index]);
+        block->blocks[index] = NULL;
+        block->sealed[index] = sealed;
+    }
+}
+
+void releaseArrayBlockBlock(ArrayBlock* block, int index) {
+    if (block->file) {
+        discardBlockFileBlock(block->file, index);
+        return;
+    }
+    if (block->sealed[index]) {
+        free(block->sealed[index]);
+        block->sealed[index] = NULL;
+    } else {
+        releasePlainBlock(block, block->blocks[index]);
+    }
+    block->blocks[index] = NULL;
+}
+
+int findInBlock(ArrayBlock* block, int index, int value, int* scratch) {
+    if (!block->file && block->sealed[index]) {
+        return findInSealedBlock(block->sealed[index], value, scratch);
+    }
+    const int* data = readBlock(block, index, scratch);
+    int length = blockLength(block, index);
+    for (int j = 0; j < length; j++) {
+        if (data[j] == value) {
+            return j;
+        }
+    }
+    return -1;
+}
+
+int countInBlock(ArrayBlock* block, int index, int value, int* scratch) {
+    if (!block->file && block->sealed[index]) {
+        return countInSealedBlock(block->sealed[index], value, scratch);
+    }
+    const int* data = readBlock(block, index, scratch);
+    int length = blockLength(block, index);
+    int count = 0;
+    for (int j = 0; j < length; j++) {
+        count += data[j] == value;
+    }
+    return count;
+}
+
+// When enabled, every block is sealed as soon as it fills up; enabling also
+// seals the blocks that are already full
+void setArrayBlockSealing(ArrayBlock* block, int enabled) {
+    block->sealFullBlocks = enabled;
+    block->resealFrom = -1;
+    block->deletesSinceReseal = 0;
+    for (int i = 0; enabled && i <= block->currentBlockIndex; i++) {
+        sealBlock(block, i);
+    }
+}
+
+// Bytes held by block storage, excluding the directory
+size_t memoryUsageArrayBlock(ArrayBlock* block) {
+    if (block->file) {
+        return (size_t)block->file->numFrames * BLOCK_STRIDE;
+    }
+    size_t bytes = 0;
+    for (int i = 0; i <= block->currentBlockIndex; i++) {
+        bytes += block->sealed[i] ? sealedBlockBytes(block->sealed[i]->bitWidth) : BLOCK_STRIDE;
+    }
+    return bytes;
+}
+
+void growArrayBlockDirectory(ArrayBlock* block, int numBlocks) {
+    block->blocks = (int**)realloc(block->blocks, numBlocks * sizeof(int*));
+    block->sealed = (SealedBlock**)realloc(block->sealed, numBlocks * sizeof(SealedBlock*));
+    if (!block->blocks || !block->sealed) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    block->numBlocks = numBlocks;
+}
+
+// Seals the full blocks that deletes have left plain. Deletes reseal on their
+// own every RESEAL_DELETE_BURST calls; call this at the end of a shorter burst
+// to get the memory back straight away.
+void resealArrayBlock(ArrayBlock* block) {
+    if (block->resealFrom >= 0) {
+        for (int k = block->resealFrom; k <= block->currentBlockIndex; k++) {
+            sealBlock(block, k);
+        }
+    }
+    block->resealFrom = -1;
+    block->deletesSinceReseal = 0;
+}
+
+void insertArrayBlock(ArrayBlock* block, int value) {
+    if (block->currentBlockSize >= BLOCK_SIZE) {
+        if (block->sealFullBlocks) {
+            if (block->resealFrom < 0) {
+                block->resealFrom = block->currentBlockIndex;
+            }
+            resealArrayBlock(block);
+        }
+        block->currentBlockIndex++;
+        block->currentBlockSize = 0;
+        if (!block->file) {
+            if (block->currentBlockIndex >= block->numBlocks) {
+                growArrayBlockDirectory(block, block->numBlocks * GROWTH_FACTOR);
+            }
+            block->blocks[block->currentBlockIndex] = acquireBlock(block->pool);
+            block->sealed[block->currentBlockIndex] = NULL;
+        }
+    }
+    writableBlock(block, block->currentBlockIndex)[block->currentBlockSize++] = value;
+}
+
+void deleteArrayBlock(ArrayBlock* block, int value) {
+    // Simple implementation: search and remove the first occurrence
+    int scratch[BLOCK_SIZE];
+    for (int i = 0; i <= block->currentBlockIndex; i++) {
+        int j = findInBlock(block, i, value, scratch);
+        if (j < 0) {
+            continue;
+        }
+        // Shift every later element one slot left, carrying the first
+        // element of each following block into the end of the previous
+        for (int k = i; k <= block->currentBlockIndex; k++) {
+            int from = k == i ? j : 0;
+            int count = blockLength(block, k);
+            int carry = k < block->currentBlockIndex ? blockFirst(block, k + 1) : 0;
+            int* data = writableBlock(block, k);
+            memmove(data + from, data + from + 1, (count - from - 1) * sizeof(int));
+            if (k < block->currentBlockIndex) {
+                data[BLOCK_SIZE - 1] = carry;
+            }
+        }
+        if (block->sealFullBlocks && (block->resealFrom < 0 || i < block->resealFrom)) {
+            block->resealFrom = i;
+        }
+        block->currentBlockSize--;
+        // Shrink: hand an emptied trailing block back to the pool
+        if (block->currentBlockSize == 0 && block->currentBlockIndex > 0) {
+            releaseArrayBlockBlock(block, block->currentBlockIndex);
+            block->currentBlockIndex--;
+            block->currentBlockSize = BLOCK_SIZE;
+        }
+        if (block->sealFullBlocks && ++block->deletesSinceReseal >= RESEAL_DELETE_BURST) {
+            resealArrayBlock(block);
+        }
+        return;
+    }
+}
+
+void printArrayBlock(ArrayBlock* block) {
+    int scratch[BLOCK_SIZE];
+    for (int i = 0; i <= block->currentBlockIndex; i++) {
+        const int* data = readBlock(block, i, scratch);
+        int length = blockLength(block, i);
+        for (int j = 0; j < length; j++) {
+            printf("%d -> ", data[j]);
+        }
+    }
+    printf("NULL\n");
+}
+
+// A file-backed ArrayBlock writes its dirty blocks back and closes the file,
+// which keeps its contents
+void clearArrayBlock(ArrayBlock* block) {
+    if (block->file) {
+        closeBlockFile(block->file);
+        block->file = NULL;
+    } else {
+        for (int i = 0; i <= block->currentBlockIndex; i++) {
+            releaseArrayBlockBlock(block, i);
+        }
+    }
+    free(block->blocks);
+    free(block->sealed);
+    unmapSnapshot(&block->snapshot);
+    block->blocks = NULL;
+    block->sealed = NULL;
+    block->numBlocks = 0;
+    block->currentBlockIndex = 0;
+    block->currentBlockSize = 0;
+    block->resealFrom = -1;
+    block->deletesSinceReseal = 0;
+}
+
+// Writes every dirty cached block of a file-backed ArrayBlock to its file
+void flushArrayBlock(ArrayBlock* block) {
+    if (block->file) {
+        flushBlockFile(block->file);
+    }
+}
+
+int saveArrayBlock(ArrayBlock* block, const char* path) {
+    static const char zeros[SNAPSHOT_PAGE_SIZE];
+    int numBlocks = block->currentBlockIndex + 1;
+    size_t dataBytes = (size_t)numBlocks * BLOCK_SIZE * sizeof(int);
+    SnapshotHeader header;
+    initSnapshotHeader(&header, SNAPSHOT_SEGMENTED_ARRAY_BLOCK, sizeArrayBlock(block), BLOCK_SIZE, dataBytes);
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        return -1;
+    }
+    int ok = fwrite(zeros, SNAPSHOT_PAGE_SIZE, 1, file) == 1;
+    uint64_t checksum = snapshotChecksum(NULL, 0);
+    int scratch[BLOCK_SIZE];
+    for (int i = 0; ok && i < numBlocks; i++) {
+        const int* data = readBlock(block, i, scratch);
+        if (i == block->currentBlockIndex) {
+            memmove(scratch, data, block->currentBlockSize * sizeof(int));
+            memset(scratch + block->currentBlockSize, 0, (BLOCK_SIZE - block->currentBlockSize) * sizeof(int));
+            data = scratch;
+        }
+        checksum = updateSnapshotChecksum(checksum, data, BLOCK_SIZE * sizeof(int));
+        ok = fwrite(data, sizeof(int), BLOCK_SIZE, file) == BLOCK_SIZE;
+    }
+    size_t padding = (SNAPSHOT_PAGE_SIZE - dataBytes % SNAPSHOT_PAGE_SIZE) % SNAPSHOT_PAGE_SIZE;
+    ok = ok && fwrite(zeros, 1, padding, file) == padding;
+
+    header.dataChecksum = checksum;
+    header.headerChecksum = snapshotChecksum(&header, offsetof(SnapshotHeader, headerChecksum));
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    return fclose(file) == 0 && ok ? 0 : -1;
+}
+
+// block must be initialised; its previous contents are released and later
+// blocks come from its pool
+int loadArrayBlock(ArrayBlock* block, const char* path, int flags) {
+    SnapshotMapping mapping;
+    SnapshotHeader header;
+    if (mapSnapshot(path, SNAPSHOT_SEGMENTED_ARRAY_BLOCK, flags, &mapping, &header) != 0) {
+        return -1;
+    }
+    int numBlocks = header.count == 0 ? 1 : (int)((header.count + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    if (header.blockSize != BLOCK_SIZE || header.dataBytes < (uint64_t)numBlocks * BLOCK_SIZE * sizeof(int)) {
+        unmapSnapshot(&mapping);
+        return -1;
+    }
+    clearArrayBlock(block);
+    block->blocks = (int**)malloc(numBlocks * sizeof(int*));
+    block->sealed = (SealedBlock**)calloc(numBlocks, sizeof(SealedBlock*));
+    if (!block->blocks || !block->sealed) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    int* data = (int*)((char*)mapping.address + header.dataOffset);
+    for (int i = 0; i < numBlocks; i++) {
+        block->blocks[i] = data + (size_t)i * BLOCK_SIZE;
+    }
+    block->snapshot = mapping;
+    block->numBlocks = numBlocks;
+    block->currentBlockIndex = numBlocks - 1;
+    block->currentBlockSize = (int)(header.count - (uint64_t)(numBlocks - 1) * BLOCK_SIZE);
+    return 0;
+}
 
-#define INITIAL_CAPACITY 10
-#define GROWTH_FACTOR 2
-#define BLOCK_SIZE 100
+// Thread Pool Implementation
+//
+// A fixed set of workers that all run the same task once per
+// runThreadPool call, each with its own index, and then report back.
 
-// Singly Linked List Implementation
+typedef struct ThreadPool {
+    pthread_t* threads;
+    int numThreads;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    void (*task)(void*, int, int);
+    void* arg;
+    long generation;
+    int pending;
+    int stopping;
+} ThreadPool;
 
-typedef struct Node {
-    int data;
-    struct Node* next;
-} Node;
+typedef struct ThreadPoolWorker {
+    ThreadPool* pool;
+    int index;
+} ThreadPoolWorker;
 
-void insert(Node** head, int value) {
-    Node* newNode = (Node*)malloc(sizeof(Node));
-    if (!newNode) {
+void* threadPoolWorker(void* arg) {
+    ThreadPoolWorker* worker = (ThreadPoolWorker*)arg;
+    ThreadPool* pool = worker->pool;
+    long seen = 0;
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == seen && !pool->stopping) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->stopping) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        pool->task(pool->arg, worker->index, pool->numThreads);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    free(worker);
+    return NULL;
+}
+
+void initThreadPool(ThreadPool* pool, int numThreads) {
+    pool->threads = (pthread_t*)malloc(numThreads * sizeof(pthread_t));
+    if (!pool->threads) {
         fprintf(stderr, "Memory allocation failed\n");
         exit(1);
     }
-    newNode->data = value;
-    newNode->next = *head;
-    *head = newNode;
+    pool->numThreads = numThreads;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->task = NULL;
+    pool->arg = NULL;
+    pool->generation = 0;
+    pool->pending = 0;
+    pool->stopping = 0;
+    for (int i = 0; i < numThreads; i++) {
+        ThreadPoolWorker* worker = (ThreadPoolWorker*)malloc(sizeof(ThreadPoolWorker));
+        if (!worker) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+        worker->pool = pool;
+        worker->index = i;
+        pthread_create(&pool->threads[i], NULL, threadPoolWorker, worker);
+    }
 }
 
-void delete(Node** head, int value) {
-    Node* temp = *head;
-    Node* prev = NULL;
-    while (temp != NULL && temp->data != value) {
-        prev = temp;
-        temp = temp->next;
+// Runs task(arg, index, numThreads) on every worker and waits for all of them
+void runThreadPool(ThreadPool* pool, void (*task)(void*, int, int), void* arg) {
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->pending = pool->numThreads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
     }
-    if (temp == NULL) return;
-    if (prev == NULL) {
-        *head = temp->next;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void destroyThreadPool(ThreadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->numThreads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+    pool->threads = NULL;
+    pool->numThreads = 0;
+}
+
+// Parallel ArrayBlock Operations
+//
+// Blocks are independent, so find, count and removeIf give each worker a
+// contiguous run of blocks and combine per-thread partial results. removeIf
+// counts survivors per thread, turns the counts into output offsets with a
+// prefix sum, and then lets every worker copy its survivors straight into a
+// freshly compacted set of blocks. Lists below PARALLEL_MIN_ELEMENTS, or a
+// NULL thread pool, take the same code path on the calling thread alone.
+// File-backed lists always run on the calling thread, and removeIf compacts
+// them in place so memory stays bounded by the block cache.
+// Predicates must be pure: removeIf evaluates them once per pass.
+
+#define PARALLEL_MIN_ELEMENTS 65536
+#define MAX_PARALLEL_THREADS 64
+
+typedef struct ParallelScan {
+    ArrayBlock* block;
+    int workers;
+    int value;
+    int (*predicate)(int, void*);
+    void* predicateArg;
+    int** newBlocks;
+    long partial[MAX_PARALLEL_THREADS];
+    long offset[MAX_PARALLEL_THREADS];
+} ParallelScan;
+
+int parallelWorkers(ThreadPool* threadPool, ArrayBlock* block) {
+    if (threadPool == NULL || block->file || sizeArrayBlock(block) < PARALLEL_MIN_ELEMENTS) {
+        return 1;
+    }
+    return threadPool->numThreads < MAX_PARALLEL_THREADS ? threadPool->numThreads : MAX_PARALLEL_THREADS;
+}
+
+void runParallelScan(ThreadPool* threadPool, int workers, void (*task)(void*, int, int), ParallelScan* scan) {
+    scan->workers = workers;
+    if (workers == 1) {
+        task(scan, 0, 1);
     } else {
-        prev->next = temp->next;
+        runThreadPool(threadPool, task, scan);
     }
-    free(temp);
 }
 
-void printList(Node* head) {
-    Node* temp = head;
-    while (temp != NULL) {
-        printf("%d -> ", temp->data);
-        temp = temp->next;
+void blockRange(ArrayBlock* block, int index, int numThreads, int* first, int* last) {
+    int total = block->currentBlockIndex + 1;
+    *first = (int)((long)total * index / numThreads);
+    *last = (int)((long)total * (index + 1) / numThreads);
+}
+
+void findTask(void* arg, int index, int numThreads) {
+    ParallelScan* scan = (ParallelScan*)arg;
+    int first, last;
+    (void)numThreads;
+    if (index >= scan->workers) return;
+    blockRange(scan->block, index, scan->workers, &first, &last);
+    int scratch[BLOCK_SIZE];
+    scan->partial[index] = -1;
+    for (int i = first; i < last; i++) {
+        int j = findInBlock(scan->block, i, scan->value, scratch);
+        if (j >= 0) {
+            scan->partial[index] = (long)i * BLOCK_SIZE + j;
+            return;
+        }
     }
-    printf("NULL\n");
 }
 
-// Array-Based List Implementation
+// Index of the first occurrence of value, or -1
+long findArrayBlockParallel(ThreadPool* threadPool, ArrayBlock* block, int value) {
+    ParallelScan scan;
+    int workers = parallelWorkers(threadPool, block);
+    scan.block = block;
+    scan.value = value;
+    runParallelScan(threadPool, workers, findTask, &scan);
+    for (int t = 0; t < workers; t++) {
+        if (scan.partial[t] >= 0) {
+            return scan.partial[t];
+        }
+    }
+    return -1;
+}
 
-typedef struct ArrayList {
-    int* data;
-    int size;
-    int capacity;
-} ArrayList;
+void countTask(void* arg, int index, int numThreads) {
+    ParallelScan* scan = (ParallelScan*)arg;
+    int first, last;
+    (void)numThreads;
+    if (index >= scan->workers) return;
+    blockRange(scan->block, index, scan->workers, &first, &last);
+    int scratch[BLOCK_SIZE];
+    long count = 0;
+    for (int i = first; i < last; i++) {
+        count += countInBlock(scan->block, i, scan->value, scratch);
+    }
+    scan->partial[index] = count;
+}
 
-void initArrayList(ArrayList* list) {
-    list->data = (int*)malloc(INITIAL_CAPACITY * sizeof(int));
-    if (!list->data) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(1);
+long countArrayBlockParallel(ThreadPool* threadPool, ArrayBlock* block, int value) {
+    ParallelScan scan;
+    int workers = parallelWorkers(threadPool, block);
+    scan.block = block;
+    scan.value = value;
+    runParallelScan(threadPool, workers, countTask, &scan);
+    long count = 0;
+    for (int t = 0; t < workers; t++) {
+        count += scan.partial[t];
     }
-    list->size = 0;
-    list->capacity = INITIAL_CAPACITY;
+    return count;
 }
 
-void insertArrayList(ArrayList* list, int value) {
-    if (list->size >= list->capacity) {
-        list->capacity *= GROWTH_FACTOR;
-        list->data = (int*)realloc(list->data, list->capacity * sizeof(int));
-        if (!list->data) {
-            fprintf(stderr, "Memory allocation failed\n");
-            exit(1);
+void keepCountTask(void* arg, int index, int numThreads) {
+    ParallelScan* scan = (ParallelScan*)arg;
+    int first, last;
+    (void)numThreads;
+    if (index >= scan->workers) return;
+    blockRange(scan->block, index, scan->workers, &first, &last);
+    int scratch[BLOCK_SIZE];
+    long kept = 0;
+    for (int i = first; i < last; i++) {
+        const int* data = readBlock(scan->block, i, scratch);
+        int length = blockLength(scan->block, i);
+        for (int j = 0; j < length; j++) {
+            kept += !scan->predicate(data[j], scan->predicateArg);
         }
     }
-    list->data[list->size++] = value;
+    scan->partial[index] = kept;
 }
 
-void deleteArrayList(ArrayList* list, int value) {
-    for (int i = 0; i < list->size; i++) {
-        if (list->data[i] == value) {
-            for (int j = i; j < list->size - 1; j++) {
-                list->data[j] = list->data[j + 1];
+void keepCopyTask(void* arg, int index, int numThreads) {
+    ParallelScan* scan = (ParallelScan*)arg;
+    int first, last;
+    (void)numThreads;
+    if (index >= scan->workers) return;
+    blockRange(scan->block, index, scan->workers, &first, &last);
+    int scratch[BLOCK_SIZE];
+    long out = scan->offset[index];
+    for (int i = first; i < last; i++) {
+        const int* data = readBlock(scan->block, i, scratch);
+        int length = blockLength(scan->block, i);
+        for (int j = 0; j < length; j++) {
+            if (!scan->predicate(data[j], scan->predicateArg)) {
+                scan->newBlocks[out / BLOCK_SIZE][out % BLOCK_SIZE] = data[j];
+                out++;
             }
-            list->size--;
-            return;
         }
     }
 }
 
-void printArrayList(ArrayList* list) {
-    for (int i = 0; i < list->size; i++) {
-        printf("%d -> ", list->data[i]);
+// Serial in-place compaction: survivors are gathered a block at a time and
+// written over blocks that have already been read
+long removeIfArrayBlockInPlace(ArrayBlock* block, int (*predicate)(int, void*), void* predicateArg) {
+    int scratch[BLOCK_SIZE];
+    int out[BLOCK_SIZE];
+    int outBlock = 0, outLength = 0;
+    int lastBlock = block->currentBlockIndex;
+    long total = sizeArrayBlock(block);
+    for (int i = 0; i <= lastBlock; i++) {
+        int length = blockLength(block, i);
+        memmove(scratch, readBlock(block, i, scratch), length * sizeof(int));
+        for (int j = 0; j < length; j++) {
+            if (!predicate(scratch[j], predicateArg)) {
+                out[outLength++] = scratch[j];
+                if (outLength == BLOCK_SIZE) {
+                    memcpy(writableBlock(block, outBlock++), out, sizeof(out));
+                    outLength = 0;
+                }
+            }
+        }
     }
-    printf("NULL\n");
+    long kept = (long)outBlock * BLOCK_SIZE + outLength;
+    if (kept == total) {
+        return 0;
+    }
+    if (outLength > 0) {
+        memcpy(writableBlock(block, outBlock), out, outLength * sizeof(int));
+    }
+    int newLast = kept == 0 ? 0 : (int)((kept - 1) / BLOCK_SIZE);
+    for (int i = newLast + 1; i <= lastBlock; i++) {
+        releaseArrayBlockBlock(block, i);
+    }
+    block->currentBlockIndex = newLast;
+    block->currentBlockSize = (int)(kept - (long)newLast * BLOCK_SIZE);
+    return total - kept;
 }
 
-// ArrayBlock Implementation
+// Removes every element matching predicate and compacts the survivors into
+// fresh blocks in their original order, resealing them if sealing is on.
+// Returns the number removed.
+long removeIfArrayBlockParallel(ThreadPool* threadPool, ArrayBlock* block, int (*predicate)(int, void*), void* predicateArg) {
+    if (block->file) {
+        return removeIfArrayBlockInPlace(block, predicate, predicateArg);
+    }
+    ParallelScan scan;
+    int workers = parallelWorkers(threadPool, block);
+    scan.block = block;
+    scan.predicate = predicate;
+    scan.predicateArg = predicateArg;
+    runParallelScan(threadPool, workers, keepCountTask, &scan);
 
-typedef struct ArrayBlock {
-    int** blocks;
-    int numBlocks;
-    int currentBlockIndex;
-    int currentBlockSize;
-} ArrayBlock;
+    long kept = 0;
+    for (int t = 0; t < workers; t++) {
+        scan.offset[t] = kept;
+        kept += scan.partial[t];
+    }
+    long removed = sizeArrayBlock(block) - kept;
+    if (removed == 0) {
+        return 0;
+    }
 
-void initArrayBlock(ArrayBlock* block) {
-    block->blocks = (int**)malloc(sizeof(int*));
-    if (!block->blocks) {
+    int numNewBlocks = kept == 0 ? 1 : (int)((kept + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    scan.newBlocks = (int**)malloc(numNewBlocks * sizeof(int*));
+    if (!scan.newBlocks) {
         fprintf(stderr, "Memory allocation failed\n");
         exit(1);
     }
-    block->blocks[0] = (int*)malloc(BLOCK_SIZE * sizeof(int));
-    if (!block->blocks[0]) {
+    for (int i = 0; i < numNewBlocks; i++) {
+        scan.newBlocks[i] = acquireBlock(block->pool);
+    }
+    runParallelScan(threadPool, workers, keepCopyTask, &scan);
+
+    int sealFullBlocks = block->sealFullBlocks;
+    clearArrayBlock(block);
+    block->blocks = scan.newBlocks;
+    block->sealed = (SealedBlock**)calloc(numNewBlocks, sizeof(SealedBlock*));
+    if (!block->sealed) {
         fprintf(stderr, "Memory allocation failed\n");
         exit(1);
     }
-    block->numBlocks = 1;
-    block->currentBlockIndex = 0;
-    block->currentBlockSize = 0;
+    block->numBlocks = numNewBlocks;
+    block->currentBlockIndex = numNewBlocks - 1;
+    block->currentBlockSize = (int)(kept - (long)(numNewBlocks - 1) * BLOCK_SIZE);
+    setArrayBlockSealing(block, sealFullBlocks);
+    return removed;
 }
 
-void insertArrayBlock(ArrayBlock* block, int value) {
-    if (block->currentBlockSize >= BLOCK_SIZE) {
-        block->currentBlockIndex++;
-        if (block->currentBlockIndex >= block->numBlocks) {
-            block->numBlocks *= GROWTH_FACTOR;
-            block->blocks = (int**)realloc(block->blocks, block->numBlocks * sizeof(int*));
-            if (!block->blocks) {
-                fprintf(stderr, "Memory allocation failed\n");
-                exit(1);
-            }
-            block->blocks[block->currentBlockIndex] = (int*)malloc(BLOCK_SIZE * sizeof(int));
-            if (!block->blocks[block->currentBlockIndex]) {
-                fprintf(stderr, "Memory allocation failed\n");
-                exit(1);
-            }
+// Parallel Sort Implementation
+//
+// Each worker copies its range of blocks into one contiguous run and radix
+// sorts it; the runs are then k-way merged through a min-heap straight back
+// into the blocks. With SORT_UNIQUE repeats are dropped during the merge and
+// the emptied trailing blocks are released. Sorting needs two temporary
+// arrays the size of the list.
+//
+// File-backed lists are sorted out of core instead: runs of as many blocks
+// as the cache holds are radix sorted in memory and written back in place,
+// then merged a block at a time into the free area past the last block and
+// copied back. Memory stays bounded by twice the cache plus one block per
+// run.
+
+typedef struct ParallelSort {
+    ArrayBlock* block;
+    int workers;
+    int* runs;
+    int* scratch;
+    long runStart[MAX_PARALLEL_THREADS + 1];
+    long cursor[MAX_PARALLEL_THREADS];
+} ParallelSort;
+
+void sortTask(void* arg, int index, int numThreads) {
+    ParallelSort* sort = (ParallelSort*)arg;
+    int first, last;
+    (void)numThreads;
+    if (index >= sort->workers) return;
+    blockRange(sort->block, index, sort->workers, &first, &last);
+    int* run = sort->runs + sort->runStart[index];
+    long length = 0;
+    for (int i = first; i < last; i++) {
+        // Sealed blocks decode straight into the run
+        int count = blockLength(sort->block, i);
+        const int* data = readBlock(sort->block, i, run + length);
+        if (data != run + length) {
+            memcpy(run + length, data, count * sizeof(int));
         }
-        block->currentBlockSize = 0;
+        length += count;
     }
-    block->blocks[block->currentBlockIndex][block->currentBlockSize++] = value;
+    radixSortInts(run, sort->scratch + sort->runStart[index], length);
 }
 
-void deleteArrayBlock(ArrayBlock* block, int value) {
-    // Simple implementation: search and remove the first occurrence
-    for (int i = 0; i <= block->currentBlockIndex; i++) {
-        for (int j = 0; j < block->currentBlockSize; j++) {
-            if (block->blocks[i][j] == value) {
-                // Shift elements to fill the gap
-                for (int k = j; k < block->currentBlockSize - 1; k++) {
-                    block->blocks[i][k] = block->blocks[i][k + 1];
-                }
-                block->currentBlockSize--;
-                return;
-            }
+int runHead(ParallelSort* sort, int run) {
+    return sort->runs[sort->cursor[run]];
+}
+
+void siftDownRuns(ParallelSort* sort, int* heap, int size, int i) {
+    for (;;) {
+        int smallest = i;
+        int left = 2 * i + 1, right = 2 * i + 2;
+        if (left < size && runHead(sort, heap[left]) < runHead(sort, heap[smallest])) smallest = left;
+        if (right < size && runHead(sort, heap[right]) < runHead(sort, heap[smallest])) smallest = right;
+        if (smallest == i) return;
+        int swap = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = swap;
+        i = smallest;
+    }
+}
+
+// Merges the sorted runs into the blocks; returns the number of elements written
+long mergeSortedRuns(ParallelSort* sort, int unique) {
+    int heap[MAX_PARALLEL_THREADS];
+    int size = 0;
+    for (int t = 0; t < sort->workers; t++) {
+        sort->cursor[t] = sort->runStart[t];
+        if (sort->runStart[t] < sort->runStart[t + 1]) {
+            heap[size++] = t;
+        }
+    }
+    for (int i = size / 2 - 1; i >= 0; i--) {
+        siftDownRuns(sort, heap, size, i);
+    }
+
+    long out = 0;
+    int* dest = NULL;
+    int previous = 0;
+    while (size > 0) {
+        int run = heap[0];
+        int value = runHead(sort, run);
+        if (++sort->cursor[run] == sort->runStart[run + 1]) {
+            heap[0] = heap[--size];
+        }
+        siftDownRuns(sort, heap, size, 0);
+        if (unique && out > 0 && value == previous) {
+            continue;
         }
+        if (out % BLOCK_SIZE == 0) {
+            dest = writableBlock(sort->block, (int)(out / BLOCK_SIZE));
+        }
+        dest[out % BLOCK_SIZE] = value;
+        previous = value;
+        out++;
     }
+    return out;
 }
 
-void printArrayBlock(ArrayBlock* block) {
-    for (int i = 0; i <= block->currentBlockIndex; i++) {
-        for (int j = 0; j < block->currentBlockSize; j++) {
-            printf("%d -> ", block->blocks[i][j]);
+typedef struct ExternalRun {
+    int block;
+    int endBlock;
+    int length;
+    int position;
+    int data[BLOCK_SIZE];
+} ExternalRun;
+
+// Loads the next block of a run; returns 0 once the run is exhausted
+int nextExternalRunBlock(ArrayBlock* block, ExternalRun* run) {
+    if (run->block == run->endBlock) {
+        return 0;
+    }
+    run->length = blockLength(block, run->block);
+    memmove(run->data, readBlock(block, run->block, run->data), run->length * sizeof(int));
+    run->block++;
+    run->position = 0;
+    return 1;
+}
+
+int externalRunHead(ExternalRun* runs, int run) {
+    return runs[run].data[runs[run].position];
+}
+
+void siftDownExternalRuns(ExternalRun* runs, int* heap, int size, int i) {
+    for (;;) {
+        int smallest = i;
+        int left = 2 * i + 1, right = 2 * i + 2;
+        if (left < size && externalRunHead(runs, heap[left]) < externalRunHead(runs, heap[smallest])) smallest = left;
+        if (right < size && externalRunHead(runs, heap[right]) < externalRunHead(runs, heap[smallest])) smallest = right;
+        if (smallest == i) return;
+        int swap = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = swap;
+        i = smallest;
+    }
+}
+
+// Out-of-core sort of a file-backed list; returns the number of elements
+// removed, or -1 if the temporary buffers cannot be allocated
+long sortArrayBlockExternal(ArrayBlock* block, int unique) {
+    long total = sizeArrayBlock(block);
+    int numBlocks = block->currentBlockIndex + 1;
+    int runBlocks = block->file->numFrames;
+    int numRuns = (numBlocks + runBlocks - 1) / runBlocks;
+    int* buffer = (int*)malloc((size_t)runBlocks * BLOCK_SIZE * sizeof(int));
+    int* scratch = (int*)malloc((size_t)runBlocks * BLOCK_SIZE * sizeof(int));
+    ExternalRun* runs = (ExternalRun*)malloc(numRuns * sizeof(ExternalRun));
+    int* heap = (int*)malloc(numRuns * sizeof(int));
+    if (!buffer || !scratch || !runs || !heap) {
+        free(buffer);
+        free(scratch);
+        free(runs);
+        free(heap);
+        return -1;
+    }
+
+    // Sort each cache-sized run in place
+    for (int r = 0; r < numRuns; r++) {
+        int first = r * runBlocks;
+        int last = first + runBlocks < numBlocks ? first + runBlocks : numBlocks;
+        long length = 0;
+        for (int b = first; b < last; b++) {
+            int count = blockLength(block, b);
+            memcpy(buffer + length, readBlock(block, b, scratch), count * sizeof(int));
+            length += count;
         }
+        radixSortInts(buffer, scratch, length);
+        for (int b = first; b < last; b++) {
+            memcpy(writableBlock(block, b), buffer + (long)(b - first) * BLOCK_SIZE, blockLength(block, b) * sizeof(int));
+        }
+        runs[r].block = first;
+        runs[r].endBlock = last;
     }
-    printf("NULL\n");
+    free(buffer);
+    free(scratch);
+
+    // Merge the runs into the blocks past the end of the list
+    int size = 0;
+    for (int r = 0; r < numRuns; r++) {
+        if (nextExternalRunBlock(block, &runs[r])) {
+            heap[size++] = r;
+        }
+    }
+    for (int i = size / 2 - 1; i >= 0; i--) {
+        siftDownExternalRuns(runs, heap, size, i);
+    }
+    int out[BLOCK_SIZE];
+    int outLength = 0;
+    int previous = 0;
+    long written = 0;
+    while (size > 0) {
+        int run = heap[0];
+        int value = externalRunHead(runs, run);
+        if (++runs[run].position == runs[run].length && !nextExternalRunBlock(block, &runs[run])) {
+            heap[0] = heap[--size];
+        }
+        siftDownExternalRuns(runs, heap, size, 0);
+        if (unique && written > 0 && value == previous) {
+            continue;
+        }
+        out[outLength++] = value;
+        previous = value;
+        written++;
+        if (outLength == BLOCK_SIZE) {
+            memcpy(writableBlock(block, numBlocks + (int)((written - 1) / BLOCK_SIZE)), out, sizeof(out));
+            outLength = 0;
+        }
+    }
+    if (outLength > 0) {
+        memcpy(writableBlock(block, numBlocks + (int)(written / BLOCK_SIZE)), out, outLength * sizeof(int));
+    }
+    free(runs);
+    free(heap);
+
+    // Copy the merged blocks back to the front and drop everything after them
+    int newLast = (int)((written - 1) / BLOCK_SIZE);
+    for (int b = 0; b <= newLast; b++) {
+        int length = b < newLast ? BLOCK_SIZE : (int)(written - (long)newLast * BLOCK_SIZE);
+        memcpy(out, readBlock(block, numBlocks + b, out), length * sizeof(int));
+        discardBlockFileBlock(block->file, numBlocks + b);
+        memcpy(writableBlock(block, b), out, length * sizeof(int));
+    }
+    truncateBlockFile(block->file, newLast + 1);
+    block->currentBlockIndex = newLast;
+    block->currentBlockSize = (int)(written - (long)newLast * BLOCK_SIZE);
+    return total - written;
+}
+
+// Sorts ascending in place; with SORT_UNIQUE repeats are dropped as well.
+// Returns the number of elements removed, or -1 if a file-backed list cannot
+// get its temporary buffers.
+long sortArrayBlockParallel(ThreadPool* threadPool, ArrayBlock* block, int flags) {
+    long total = sizeArrayBlock(block);
+    if (total < 2) {
+        return 0;
+    }
+    if (block->file) {
+        return sortArrayBlockExternal(block, flags & SORT_UNIQUE);
+    }
+    ParallelSort sort;
+    sort.block = block;
+    sort.workers = parallelWorkers(threadPool, block);
+    sort.runs = (int*)malloc(total * sizeof(int));
+    sort.scratch = (int*)malloc(total * sizeof(int));
+    if (!sort.runs || !sort.scratch) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    for (int t = 0; t < sort.workers; t++) {
+        int first, last;
+        blockRange(block, t, sort.workers, &first, &last);
+        sort.runStart[t] = (long)first * BLOCK_SIZE;
+    }
+    sort.runStart[sort.workers] = total;
+    if (sort.workers == 1) {
+        sortTask(&sort, 0, 1);
+    } else {
+        runThreadPool(threadPool, sortTask, &sort);
+    }
+
+    long kept = mergeSortedRuns(&sort, flags & SORT_UNIQUE);
+    free(sort.runs);
+    free(sort.scratch);
+    if (kept < total) {
+        int lastBlock = block->currentBlockIndex;
+        int newLast = (int)((kept - 1) / BLOCK_SIZE);
+        for (int i = newLast + 1; i <= lastBlock; i++) {
+            releaseArrayBlockBlock(block, i);
+        }
+        block->currentBlockIndex = newLast;
+        block->currentBlockSize = (int)(kept - (long)newLast * BLOCK_SIZE);
+    }
+    setArrayBlockSealing(block, block->sealFullBlocks);
+    return total - kept;
+}
+
+// Concurrent ArrayBlock Implementation
+//
+// Lock-free multi-producer append. A writer reserves slots with an atomic
+// fetch-add on `reserved`, installs the block holding them by CAS if no other
+// writer has yet, stores its values and then bumps that block's `written`
+// counter with release ordering. The block directory is preallocated for
+// maxBlocks blocks, so block pointers never move and readers need no lock.
+// Readers only look below publishedConcurrentArrayBlock(): every slot in that
+// prefix is written and visible.
+
+typedef struct ConcurrentArrayBlock {
+    _Atomic(int*)* blocks;
+    atomic_int* written;
+    int maxBlocks;
+    atomic_long reserved;
+    atomic_long published;
+} ConcurrentArrayBlock;
+
+void initConcurrentArrayBlock(ConcurrentArrayBlock* block, int maxBlocks) {
+    block->blocks = (_Atomic(int*)*)malloc(maxBlocks * sizeof(*block->blocks));
+    block->written = (atomic_int*)malloc(maxBlocks * sizeof(*block->written));
+    if (!block->blocks || !block->written) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < maxBlocks; i++) {
+        atomic_init(&block->blocks[i], NULL);
+        atomic_init(&block->written[i], 0);
+    }
+    block->maxBlocks = maxBlocks;
+    atomic_init(&block->reserved, 0);
+    atomic_init(&block->published, 0);
+}
+
+int* installConcurrentBlock(ConcurrentArrayBlock* block, long index) {
+    if (index >= block->maxBlocks) {
+        fprintf(stderr, "ConcurrentArrayBlock capacity exceeded\n");
+        exit(1);
+    }
+    int* data = atomic_load_explicit(&block->blocks[index], memory_order_acquire);
+    if (data) {
+        return data;
+    }
+    int* fresh = (int*)aligned_alloc(CACHE_LINE_SIZE, BLOCK_STRIDE);
+    if (!fresh) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    if (atomic_compare_exchange_strong_explicit(&block->blocks[index], &data, fresh,
+                                                memory_order_acq_rel, memory_order_acquire)) {
+        return fresh;
+    }
+    // Another writer won the race; data now holds its block
+    free(fresh);
+    return data;
+}
+
+void appendConcurrentArrayBlockBatch(ConcurrentArrayBlock* block, const int* values, int count) {
+    long slot = atomic_fetch_add_explicit(&block->reserved, count, memory_order_relaxed);
+    while (count > 0) {
+        long index = slot / BLOCK_SIZE;
+        int offset = (int)(slot % BLOCK_SIZE);
+        int chunk = BLOCK_SIZE - offset < count ? BLOCK_SIZE - offset : count;
+        int* data = installConcurrentBlock(block, index);
+        memcpy(data + offset, values, chunk * sizeof(int));
+        atomic_fetch_add_explicit(&block->written[index], chunk, memory_order_release);
+        slot += chunk;
+        values += chunk;
+        count -= chunk;
+    }
+}
+
+void appendConcurrentArrayBlock(ConcurrentArrayBlock* block, int value) {
+    appendConcurrentArrayBlockBatch(block, &value, 1);
+}
+
+// Length of the longest fully written prefix. A partially filled block counts
+// only when its written counter matches the slots reserved in it: written is
+// read first, so every counted slot was reserved before `reserved` is read.
+long publishedConcurrentArrayBlock(ConcurrentArrayBlock* block) {
+    long seen = atomic_load_explicit(&block->published, memory_order_acquire);
+    long prefix = seen;
+    while (prefix / BLOCK_SIZE < block->maxBlocks) {
+        long index = prefix / BLOCK_SIZE;
+        long blockStart = index * BLOCK_SIZE;
+        int written = atomic_load_explicit(&block->written[index], memory_order_acquire);
+        if (written == BLOCK_SIZE) {
+            prefix = blockStart + BLOCK_SIZE;
+            continue;
+        }
+        long reserved = atomic_load_explicit(&block->reserved, memory_order_relaxed) - blockStart;
+        if (reserved > BLOCK_SIZE) {
+            reserved = BLOCK_SIZE;
+        }
+        if (written == reserved) {
+            prefix = blockStart + written;
+        }
+        break;
+    }
+    while (seen < prefix &&
+           !atomic_compare_exchange_weak_explicit(&block->published, &seen, prefix,
+                                                  memory_order_release, memory_order_acquire)) {
+    }
+    return prefix;
+}
+
+// index must lie below a value returned by publishedConcurrentArrayBlock
+int getConcurrentArrayBlock(ConcurrentArrayBlock* block, long index) {
+    int* data = atomic_load_explicit(&block->blocks[index / BLOCK_SIZE], memory_order_acquire);
+    return data[index % BLOCK_SIZE];
+}
+
+// Not safe against concurrent appends or reads
+void destroyConcurrentArrayBlock(ConcurrentArrayBlock* block) {
+    for (int i = 0; i < block->maxBlocks; i++) {
+        free(atomic_load_explicit(&block->blocks[i], memory_order_relaxed));
+    }
+    free(block->blocks);
+    free(block->written);
+    block->blocks = NULL;
+    block->written = NULL;
+    block->maxBlocks = 0;
 }
 
 // Benchmarking
@@ -232,6 +2091,65 @@ void benchmarkDelete(void* arg, int numElements) {
     }
 }
 
+typedef struct ConcurrentInsertTask {
+    ConcurrentArrayBlock* block;
+    int first;
+    int count;
+} ConcurrentInsertTask;
+
+void* concurrentInsertWorker(void* arg) {
+    ConcurrentInsertTask* task = (ConcurrentInsertTask*)arg;
+    for (int i = 0; i < task->count; i++) {
+        appendConcurrentArrayBlock(task->block, task->first + i);
+    }
+    return NULL;
+}
+
+// Wall-clock time for numThreads producers appending numElements values in
+// total to one shared ConcurrentArrayBlock
+double timeConcurrentInsert(int numThreads, int numElements) {
+    ConcurrentArrayBlock block;
+    initConcurrentArrayBlock(&block, numElements / BLOCK_SIZE + 1);
+    pthread_t* threads = (pthread_t*)malloc(numThreads * sizeof(pthread_t));
+    ConcurrentInsertTask* tasks = (ConcurrentInsertTask*)malloc(numThreads * sizeof(ConcurrentInsertTask));
+    if (!threads || !tasks) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int t = 0; t < numThreads; t++) {
+        tasks[t].block = &block;
+        tasks[t].first = (int)((long)numElements * t / numThreads);
+        tasks[t].count = (int)((long)numElements * (t + 1) / numThreads) - tasks[t].first;
+        pthread_create(&threads[t], NULL, concurrentInsertWorker, &tasks[t]);
+    }
+    for (int t = 0; t < numThreads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (publishedConcurrentArrayBlock(&block) != numElements) {
+        fprintf(stderr, "ConcurrentArrayBlock lost appends\n");
+        exit(1);
+    }
+    free(threads);
+    free(tasks);
+    destroyConcurrentArrayBlock(&block);
+    return (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int isOdd(int value, void* arg) {
+    (void)arg;
+    return value & 1;
+}
+
+int compareInts(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
 int main() {
     Node* linkedList = NULL;
     ArrayList arrayList;
@@ -259,6 +2177,126 @@ int main() {
     printf("Time for array list delete: %f seconds\n", timeArrayDelete);
     printf("Time for array block delete: %f seconds\n", timeBlockDelete);
 
+    // Benchmark concurrent appends
+    int numConcurrentElements = 1000000;
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        printf("Time for concurrent array block insert (%d threads): %f seconds\n",
+               threads, timeConcurrentInsert(threads, numConcurrentElements));
+    }
+
+    // Benchmark parallel scans over a large array block
+    int numParallelElements = 10000000;
+    ThreadPool threadPool;
+    initThreadPool(&threadPool, (int)sysconf(_SC_NPROCESSORS_ONLN));
+    ArrayBlock bigBlock;
+    initArrayBlock(&bigBlock);
+    for (int i = 0; i < numParallelElements; i++) {
+        insertArrayBlock(&bigBlock, i);
+    }
+    struct timespec parallelStart, parallelEnd;
+    clock_gettime(CLOCK_MONOTONIC, &parallelStart);
+    long found = countArrayBlockParallel(&threadPool, &bigBlock, numParallelElements - 1);
+    long removed = removeIfArrayBlockParallel(&threadPool, &bigBlock, isOdd, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &parallelEnd);
+    printf("Time for parallel count (%ld) and removeIf (%ld) on %d threads: %f seconds\n", found, removed,
+           threadPool.numThreads,
+           (double)(parallelEnd.tv_sec - parallelStart.tv_sec) + (double)(parallelEnd.tv_nsec - parallelStart.tv_nsec) / 1e9);
+
+    // Benchmark scans over sealed (compressed) blocks against plain ones, on
+    // constant-stride data (closed-form search) and on random values in
+    // 0..999 (full unpack and running sum per block)
+    ArrayBlock plainBlock, sealedBlock, plainRandomBlock, sealedRandomBlock;
+    initArrayBlock(&plainBlock);
+    initArrayBlock(&sealedBlock);
+    initArrayBlock(&plainRandomBlock);
+    initArrayBlock(&sealedRandomBlock);
+    setArrayBlockSealing(&sealedBlock, 1);
+    setArrayBlockSealing(&sealedRandomBlock, 1);
+    for (int i = 0; i < numParallelElements; i++) {
+        int value = rand() % 1000;
+        insertArrayBlock(&plainBlock, i);
+        insertArrayBlock(&sealedBlock, i);
+        insertArrayBlock(&plainRandomBlock, value);
+        insertArrayBlock(&sealedRandomBlock, value);
+    }
+    ArrayBlock* scanBlocks[4] = { &plainBlock, &sealedBlock, &plainRandomBlock, &sealedRandomBlock };
+    const char* scanNames[4] = { "plain", "sealed", "plain random", "sealed random" };
+    for (int b = 0; b < 4; b++) {
+        clock_gettime(CLOCK_MONOTONIC, &parallelStart);
+        long hits = 0;
+        for (int v = 0; v < 100; v++) {
+            hits += countArrayBlockParallel(&threadPool, scanBlocks[b], b < 2 ? v * (numParallelElements / 100) : v);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &parallelEnd);
+        printf("Time for 100 counts over %s array block (%zu bytes, %ld hits): %f seconds\n", scanNames[b],
+               memoryUsageArrayBlock(scanBlocks[b]), hits,
+               (double)(parallelEnd.tv_sec - parallelStart.tv_sec) + (double)(parallelEnd.tv_nsec - parallelStart.tv_nsec) / 1e9);
+    }
+
+    // Deletes near the front leave every later block plain until the burst
+    // ends and resealArrayBlock compresses them again
+    clock_gettime(CLOCK_MONOTONIC, &parallelStart);
+    for (int i = 0; i < 10; i++) {
+        deleteArrayBlock(&sealedBlock, i);
+    }
+    size_t burstBytes = memoryUsageArrayBlock(&sealedBlock);
+    resealArrayBlock(&sealedBlock);
+    clock_gettime(CLOCK_MONOTONIC, &parallelEnd);
+    printf("Time for 10 front deletes and reseal on sealed array block (%zu bytes during, %zu bytes after): %f seconds\n",
+           burstBytes, memoryUsageArrayBlock(&sealedBlock),
+           (double)(parallelEnd.tv_sec - parallelStart.tv_sec) + (double)(parallelEnd.tv_nsec - parallelStart.tv_nsec) / 1e9);
+    clearArrayBlock(&plainBlock);
+    clearArrayBlock(&sealedBlock);
+    clearArrayBlock(&plainRandomBlock);
+    clearArrayBlock(&sealedRandomBlock);
+
+    // Benchmark an out-of-core array block holding the same data through a
+    // small block cache
+    ArrayBlock fileBlock;
+    if (initArrayBlockFileBacked(&fileBlock, "array_block.bin", 64) == 0) {
+        clock_gettime(CLOCK_MONOTONIC, &parallelStart);
+        for (int i = 0; i < numParallelElements; i++) {
+            insertArrayBlock(&fileBlock, i);
+        }
+        long hits = countArrayBlockParallel(&threadPool, &fileBlock, numParallelElements / 2);
+        flushArrayBlock(&fileBlock);
+        clock_gettime(CLOCK_MONOTONIC, &parallelEnd);
+        printf("Time for insert, count and flush on file-backed array block (%zu bytes cached, %ld hits): %f seconds\n",
+               memoryUsageArrayBlock(&fileBlock), hits,
+               (double)(parallelEnd.tv_sec - parallelStart.tv_sec) + (double)(parallelEnd.tv_nsec - parallelStart.tv_nsec) / 1e9);
+        clearArrayBlock(&fileBlock);
+        unlink("array_block.bin");
+    }
+
+    // Benchmark the parallel radix sort against qsort over a copied array
+    ArrayBlock sortBlock;
+    initArrayBlock(&sortBlock);
+    int* sortCopy = (int*)malloc(numParallelElements * sizeof(int));
+    if (!sortCopy) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < numParallelElements; i++) {
+        int value = rand();
+        insertArrayBlock(&sortBlock, value);
+        sortCopy[i] = value;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &parallelStart);
+    qsort(sortCopy, numParallelElements, sizeof(int), compareInts);
+    clock_gettime(CLOCK_MONOTONIC, &parallelEnd);
+    printf("Time for qsort over a copied array: %f seconds\n",
+           (double)(parallelEnd.tv_sec - parallelStart.tv_sec) + (double)(parallelEnd.tv_nsec - parallelStart.tv_nsec) / 1e9);
+    clock_gettime(CLOCK_MONOTONIC, &parallelStart);
+    long duplicates = sortArrayBlockParallel(&threadPool, &sortBlock, SORT_UNIQUE);
+    clock_gettime(CLOCK_MONOTONIC, &parallelEnd);
+    printf("Time for parallel sortedUnique (%ld duplicates) on %d threads: %f seconds\n", duplicates,
+           threadPool.numThreads,
+           (double)(parallelEnd.tv_sec - parallelStart.tv_sec) + (double)(parallelEnd.tv_nsec - parallelStart.tv_nsec) / 1e9);
+    free(sortCopy);
+    clearArrayBlock(&sortBlock);
+    clearArrayBlock(&bigBlock);
+    destroyThreadPool(&threadPool);
+
     // Clean up
     // Free linked list
     while (linkedList != NULL) {
@@ -268,13 +2306,11 @@ int main() {
     }
 
     // Free array list
-    free(arrayList.data);
+    freeArrayList(&arrayList);
 
     // Free array block
-    for (int i = 0; i < arrayBlock.numBlocks; i++) {
-        free(arrayBlock.blocks[i]);
-    }
-    free(arrayBlock.blocks);
+    clearArrayBlock(&arrayBlock);
+    destroyBlockPool(&defaultBlockPool);
 
     return 0;
 }
@@ -8,6 +8,14 @@ typedef struct ListNode {
     struct ListNode *next;
 } ListNode;
 
+// Linked List handle: head, tail and element count, so appends and splices
+// never walk the list
+typedef struct {
+    ListNode *head;
+    ListNode *tail;
+    int size;
+} LinkedList;
+
 // Array List
 typedef struct {
     int *data;
@@ -30,6 +38,15 @@ void deleteNodeLinkedList(ListNode **head, int data);
 void printLinkedList(ListNode *head);
 void freeLinkedList(ListNode *head);
 
+void initLinkedList(LinkedList *list);
+void appendLinkedList(LinkedList *list, int data);
+void appendArrayLinkedList(LinkedList *list, const int *values, int count);
+void spliceLinkedList(LinkedList *list, LinkedList *other);
+void deleteLinkedList(LinkedList *list, int data);
+void deleteLinkedListPrefetch(LinkedList *list, int data);
+void findBatchLinkedList(LinkedList *list, const int *keys, ListNode **results, int count);
+void clearLinkedList(LinkedList *list);
+
 void initArrayList(ArrayList *list, int capacity);
 void insertAtEndArrayList(ArrayList *list, int data);
 void deleteElementArrayList(ArrayList *list, int data);
@@ -103,6 +120,123 @@ void freeLinkedList(ListNode *head) {
     }
 }
 
+// Linked List Handle Functions
+void initLinkedList(LinkedList *list) {
+    list->head = NULL;
+    list->tail = NULL;
+    list->size = 0;
+}
+
+void appendLinkedList(LinkedList *list, int data) {
+    ListNode *newNode = createListNode(data);
+    if (list->tail == NULL) {
+        list->head = newNode;
+    } else {
+        list->tail->next = newNode;
+    }
+    list->tail = newNode;
+    list->size++;
+}
+
+void appendArrayLinkedList(LinkedList *list, const int *values, int count) {
+    for (int i = 0; i < count; i++) {
+        appendLinkedList(list, values[i]);
+    }
+}
+
+// Moves every node of other onto the end of list in O(1); other is left
+// empty. Splicing a list onto itself does nothing.
+void spliceLinkedList(LinkedList *list, LinkedList *other) {
+    if (other == list || other->head == NULL) return;
+    if (list->tail == NULL) {
+        list->head = other->head;
+    } else {
+        list->tail->next = other->head;
+    }
+    list->tail = other->tail;
+    list->size += other->size;
+    initLinkedList(other);
+}
+
+void deleteLinkedList(LinkedList *list, int data) {
+    ListNode *temp = list->head, *prev = NULL;
+    while (temp != NULL && temp->data != data) {
+        prev = temp;
+        temp = temp->next;
+    }
+    if (temp == NULL) return;
+    if (prev == NULL) {
+        list->head = temp->next;
+    } else {
+        prev->next = temp->next;
+    }
+    if (list->tail == temp) {
+        list->tail = prev;
+    }
+    list->size--;
+    free(temp);
+}
+
+// Prefetching variant of deleteLinkedList: while comparing a node, the node
+// two hops ahead is already being fetched.
+void deleteLinkedListPrefetch(LinkedList *list, int data) {
+    ListNode *temp = list->head, *prev = NULL;
+    if (temp != NULL) {
+        __builtin_prefetch(temp->next);
+    }
+    while (temp != NULL && temp->data != data) {
+        if (temp->next != NULL) {
+            __builtin_prefetch(temp->next->next);
+        }
+        prev = temp;
+        temp = temp->next;
+    }
+    if (temp == NULL) return;
+    if (prev == NULL) {
+        list->head = temp->next;
+    } else {
+        prev->next = temp->next;
+    }
+    if (list->tail == temp) {
+        list->tail = prev;
+    }
+    list->size--;
+    free(temp);
+}
+
+#define LOOKUP_BATCH 8
+
+// Batched lookup: keys are answered LOOKUP_BATCH at a time by one walk of the
+// list that tests each node against every pending key of the group, so the
+// list is traversed once per group instead of once per key. The node two hops
+// ahead is prefetched while the current one is tested. results[i] is the
+// first node holding keys[i], or NULL.
+void findBatchLinkedList(LinkedList *list, const int *keys, ListNode **results, int count) {
+    for (int base = 0; base < count; base += LOOKUP_BATCH) {
+        int lanes = count - base < LOOKUP_BATCH ? count - base : LOOKUP_BATCH;
+        int pending = lanes;
+        for (int i = 0; i < lanes; i++) {
+            results[base + i] = NULL;
+        }
+        for (ListNode *temp = list->head; temp != NULL && pending > 0; temp = temp->next) {
+            if (temp->next != NULL) {
+                __builtin_prefetch(temp->next->next);
+            }
+            for (int i = 0; i < lanes; i++) {
+                if (results[base + i] == NULL && temp->data == keys[base + i]) {
+                    results[base + i] = temp;
+                    pending--;
+                }
+            }
+        }
+    }
+}
+
+void clearLinkedList(LinkedList *list) {
+    freeLinkedList(list->head);
+    initLinkedList(list);
+}
+
 // Array List Functions
 void initArrayList(ArrayList *list, int capacity) {
     list->data = (int *)malloc(capacity * sizeof(int));
@@ -202,17 +336,56 @@ void benchmark() {
     const int blockSize = 1024;
 
     // Linked List
-    ListNode *head = NULL;
+    LinkedList linkedList;
+    initLinkedList(&linkedList);
     clock_t start = clock();
     for (int i = 0; i < numOperations; i++) {
-        insertAtEndLinkedList(&head, i);
+        appendLinkedList(&linkedList, i);
     }
-    for (int i = 0; i < numOperations; i++) {
-        deleteNodeLinkedList(&head, i);
+    // Delete from the tail end so every delete walks the whole list
+    for (int i = numOperations - 1; i >= 0; i--) {
+        deleteLinkedList(&linkedList, i);
     }
     clock_t end = clock();
     double timeLinkedList = (double)(end - start) / CLOCKS_PER_SEC;
-    freeLinkedList(head);
+    clearLinkedList(&linkedList);
+
+    // Linked List with prefetching delete
+    initLinkedList(&linkedList);
+    start = clock();
+    for (int i = 0; i < numOperations; i++) {
+        appendLinkedList(&linkedList, i);
+    }
+    // Delete from the tail end so every delete walks the whole list
+    for (int i = numOperations - 1; i >= 0; i--) {
+        deleteLinkedListPrefetch(&linkedList, i);
+    }
+    end = clock();
+    double timeLinkedListPrefetch = (double)(end - start) / CLOCKS_PER_SEC;
+    clearLinkedList(&linkedList);
+
+    // Linked List lookups, one key per walk against LOOKUP_BATCH keys per walk
+    const int numLookups = 1024;
+    int keys[1024];
+    ListNode *results[1024];
+    for (int i = 0; i < numLookups; i++) {
+        keys[i] = rand() % numOperations;
+    }
+    initLinkedList(&linkedList);
+    for (int i = 0; i < numOperations; i++) {
+        appendLinkedList(&linkedList, i);
+    }
+    start = clock();
+    for (int i = 0; i < numLookups; i++) {
+        findBatchLinkedList(&linkedList, &keys[i], &results[i], 1);
+    }
+    end = clock();
+    double timeLookupSingle = (double)(end - start) / CLOCKS_PER_SEC;
+    start = clock();
+    findBatchLinkedList(&linkedList, keys, results, numLookups);
+    end = clock();
+    double timeLookupBatch = (double)(end - start) / CLOCKS_PER_SEC;
+    clearLinkedList(&linkedList);
 
     // Array List
     ArrayList arrayList;
@@ -244,6 +417,9 @@ void benchmark() {
 
     // Print results
     printf("Time for Linked List: %.6f seconds\n", timeLinkedList);
+    printf("Time for Linked List (prefetch): %.6f seconds\n", timeLinkedListPrefetch);
+    printf("Time for Linked List lookups (single): %.6f seconds\n", timeLookupSingle);
+    printf("Time for Linked List lookups (batch of %d): %.6f seconds\n", LOOKUP_BATCH, timeLookupBatch);
     printf("Time for Array List: %.6f seconds\n", timeArrayList);
     printf("Time for Array Block: %.6f seconds\n", timeArrayBlock);
 }